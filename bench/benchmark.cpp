@@ -0,0 +1,274 @@
+/*
+	Benchmarks for the hot paths of RoboSim: model access, row insertion
+	and removal, scene file parsing and scene synchronisation. Runs
+	without a display and prints one result per line as CSV or JSON.
+
+	RoboSimBench [--format csv|json] [--output file] [--sizes n,n,...]
+*/
+#include <iostream>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardItemModel>
+#include <QStringList>
+#include <QTextStream>
+
+#include "robotmodel.h"
+#include "scenesync.h"
+#include "xmldom.h"
+#include "xmlreader.h"
+#include "xmlwriter.h"
+
+namespace {
+	struct benchResult {
+		QString name;
+		int robots;
+		int operations;
+		double ms;
+		qint64 bytes;
+	};
+
+	std::vector<benchResult> results;
+
+	void record(const QString &name, int robots, int operations, const QElapsedTimer &timer, qint64 bytes = 0) {
+		benchResult r;
+		r.name = name;
+		r.robots = robots;
+		r.operations = operations;
+		r.ms = timer.nsecsElapsed()/1.0e6;
+		r.bytes = bytes;
+		results.push_back(r);
+		std::cerr << qPrintable(name) << " " << robots << ": " << r.ms << " ms" << std::endl;
+	}
+
+	/*
+		Fills a model with n Linkbots on a square lattice so none overlap.
+	*/
+	void fill(robotModel *model, int n) {
+		model->removeRows(0, model->rowCount());
+		std::vector<rsModel::RobotSpec> specs(n);
+		int side = 1;
+		while (side*side < n) side++;
+		for (int i = 0; i < n; i++) {
+			specs[i].form = (i % 3 == 2) ? rs::LINKBOTL : rs::LINKBOTI;
+			specs[i].p[0] = (i % side)*0.25;
+			specs[i].p[1] = (i / side)*0.25;
+		}
+		model->addRobots(specs);
+	}
+
+	void bench_model(int n) {
+		robotModel model;
+		fill(&model, n);
+
+		// read every cell through the item model interface
+		QElapsedTimer timer;
+		timer.start();
+		int reads = 0;
+		for (int i = 0; i < n; i++) {
+			for (int j = 0; j < rsModel::NUM_COLUMNS; j++) {
+				model.data(model.index(i, j), Qt::DisplayRole);
+				model.data(model.index(i, j), Qt::EditRole);
+				reads += 2;
+			}
+		}
+		record("model_data", n, reads, timer);
+
+		// write one position per robot, each notified on its own
+		timer.restart();
+		for (int i = 0; i < n; i++)
+			model.setData(model.index(i, rsModel::P_Z), 0.01*(i % 7));
+		record("model_setdata", n, n, timer);
+
+		// same writes merged into one notification
+		timer.restart();
+		model.beginUpdate();
+		for (int i = 0; i < n; i++)
+			model.setData(model.index(i, rsModel::P_Z), 0.02*(i % 5));
+		model.endUpdate();
+		record("model_setdata_update", n, n, timer);
+	}
+
+	void bench_rows(int n) {
+		robotModel model;
+		fill(&model, 0);
+
+		QElapsedTimer timer;
+		timer.start();
+		model.insertRows(model.rowCount(), n);
+		record("model_insertrows", n, 1, timer);
+
+		timer.restart();
+		for (int i = 0; i < 100 && model.rowCount() > 1; i++)
+			model.removeRows(0, 1);
+		record("model_removerows_front", n, 100, timer);
+
+		timer.restart();
+		model.removeRows(0, model.rowCount());
+		record("model_removerows_all", n, 1, timer);
+
+		timer.restart();
+		fill(&model, n);
+		record("model_addrobots", n, 1, timer);
+	}
+
+	void bench_parse(int n) {
+		QString fileName = QDir::temp().filePath(QString("robosimbench_%1.xml").arg(n));
+		{
+			robotModel model;
+			fill(&model, n);
+			xmlWriter writer(&model);
+			if (!writer.write(fileName)) {
+				std::cerr << "Error: Cannot write " << qPrintable(fileName) << std::endl;
+				return;
+			}
+		}
+		qint64 bytes = QFileInfo(fileName).size();
+
+		QElapsedTimer timer;
+		timer.start();
+		{
+			robotModel model;
+			xmlReader reader(&model);
+			reader.read(fileName);
+		}
+		record("xmlreader_read", n, 1, timer, bytes);
+
+		timer.restart();
+		{
+			QStandardItemModel model(0, rsModel::NUM_COLUMNS);
+			xmlDom dom(fileName);
+			int version = 0;
+			dom.parseConfig(version);
+			dom.parseSim(&model);
+		}
+		record("xmldom_parse", n, 1, timer, bytes);
+
+		QFile::remove(fileName);
+	}
+
+	void bench_sync(int n) {
+		robotModel model;
+		fill(&model, n);
+
+		// build every robot instance
+		sceneSync sync;
+		sync.setAsync(false);
+		QElapsedTimer timer;
+		timer.start();
+		sync.setModel(&model);
+		record("scenesync_build", n, n, timer);
+
+		// move every robot in one update
+		timer.restart();
+		model.beginUpdate();
+		for (int i = 0; i < n; i++)
+			model.setDouble(i, rsModel::R_PSI, 90);
+		model.endUpdate();
+		record("scenesync_pose_update", n, n, timer);
+
+		// move every robot with one notification each
+		timer.restart();
+		for (int i = 0; i < n; i++)
+			model.setDouble(i, rsModel::R_PSI, 0);
+		record("scenesync_pose_cells", n, n, timer);
+
+		// change the wheels of every robot
+		timer.restart();
+		model.beginUpdate();
+		for (int i = 0; i < n; i++)
+			model.setInt(i, rsModel::WHEEL, 3);
+		model.endUpdate();
+		record("scenesync_rebuild", n, n, timer);
+	}
+
+	void write_csv(QTextStream &out) {
+		out << "benchmark,robots,operations,total_ms,per_op_us,bytes\n";
+		for (unsigned int i = 0; i < results.size(); i++) {
+			const benchResult &r = results[i];
+			out << r.name << "," << r.robots << "," << r.operations << ","
+				<< QString::number(r.ms, 'f', 3) << ","
+				<< QString::number(1000*r.ms/qMax(r.operations, 1), 'f', 4) << ","
+				<< r.bytes << "\n";
+		}
+	}
+
+	void usage(void) {
+		std::cerr << "usage: RoboSimBench [--format csv|json] [--output file] [--sizes n,n,...]" << std::endl;
+	}
+
+	void write_json(QTextStream &out) {
+		out << "[\n";
+		for (unsigned int i = 0; i < results.size(); i++) {
+			const benchResult &r = results[i];
+			out << "  {\"benchmark\": \"" << r.name << "\", \"robots\": " << r.robots
+				<< ", \"operations\": " << r.operations
+				<< ", \"total_ms\": " << QString::number(r.ms, 'f', 3)
+				<< ", \"per_op_us\": " << QString::number(1000*r.ms/qMax(r.operations, 1), 'f', 4)
+				<< ", \"bytes\": " << r.bytes << "}"
+				<< ((i + 1 < results.size()) ? ",\n" : "\n");
+		}
+		out << "]\n";
+	}
+}
+
+int main(int argc, char *argv[]) {
+	QCoreApplication app(argc, argv);
+
+	// parse options
+	QString format("csv"), output;
+	QList<int> sizes;
+	QStringList args = app.arguments();
+	for (int i = 1; i < args.size(); i++) {
+		if (args[i] == "--format" && i + 1 < args.size())
+			format = args[++i];
+		else if (args[i] == "--output" && i + 1 < args.size())
+			output = args[++i];
+		else if (args[i] == "--sizes" && i + 1 < args.size()) {
+			QStringList list = args[++i].split(",", QString::SkipEmptyParts);
+			for (int j = 0; j < list.size(); j++)
+				if (list[j].toInt() > 0) sizes << list[j].toInt();
+		}
+		else {
+			usage();
+			return 1;
+		}
+	}
+	if (format != "csv" && format != "json") {
+		usage();
+		return 1;
+	}
+	if (sizes.isEmpty())
+		sizes << 100 << 1000 << 10000;
+
+	// run benchmarks
+	for (int i = 0; i < sizes.size(); i++) {
+		bench_model(sizes[i]);
+		bench_rows(sizes[i]);
+		bench_parse(sizes[i]);
+		bench_sync(sizes[i]);
+	}
+
+	// write results
+	QFile file;
+	if (output.isEmpty())
+		file.open(stdout, QIODevice::WriteOnly);
+	else {
+		file.setFileName(output);
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+			std::cerr << "Error: Cannot write " << qPrintable(output) << std::endl;
+			return 1;
+		}
+	}
+	QTextStream out(&file);
+	if (format == "json")
+		write_json(out);
+	else
+		write_csv(out);
+
+	return 0;
+}
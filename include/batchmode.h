@@ -0,0 +1,36 @@
+#ifndef BATCHMODE_H_
+#define BATCHMODE_H_
+
+#include <iostream>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QStringList>
+
+#include "obstaclemodel.h"
+#include "obstaclesync.h"
+#include "robotmodel.h"
+#include "scenefile.h"
+#include "scenesync.h"
+#include "scenevalidator.h"
+
+class batchMode {
+	public:
+		batchMode(const QStringList&);
+		int exec(void);
+
+		static bool requested(int, char**);
+
+	private:
+		bool process(const QString&);
+		bool validate(sceneFile&, const QString&);
+		void usage(void);
+
+		QStringList _files;
+		QString _format;
+		QString _output;
+		bool _check;
+		bool _error;
+};
+
+#endif // BATCHMODE_H_
@@ -0,0 +1,97 @@
+#ifndef BINARYSCENE_H_
+#define BINARYSCENE_H_
+
+#include <vector>
+
+#include <QFile>
+#include <QtGlobal>
+
+#include "obstaclemodel.h"
+#include "robotmodel.h"
+#include "xmlreader.h"
+
+namespace rsModel {
+
+	/*
+		On-disk layout of a binary scene, version 1:
+
+			SceneHeader
+			RobotRecord[num_robots]
+			ObstacleRecord[num_obstacles]
+
+		All values are stored in the byte order of the machine that wrote
+		the file, which is recorded in byte_order. Records are fixed size
+		so the file can be mapped and read in place.
+	*/
+	struct SceneHeader {
+		char magic[4];			// "RSSB"
+		quint32 version;
+		quint32 byte_order;		// 0x01020304 as written
+		quint32 robot_size;		// sizeof(RobotRecord)
+		quint32 obstacle_size;	// sizeof(ObstacleRecord)
+		quint32 num_robots;
+		quint32 num_obstacles;
+		qint32 config_version;
+		qint32 tracking;
+		quint32 tag;			// free for the writer, e.g. a snapshot generation
+		double grid[7];
+	};
+
+	// one robot, fields in robot_item_list order
+	struct RobotRecord {
+		qint32 id;
+		qint32 form;
+		double p[3];
+		double r[3];
+		double radius;
+		qint32 wheel;
+		qint32 preconfig;
+	};
+
+	struct ObstacleRecord {
+		qint32 type;
+		qint32 reserved;
+		double p[3];
+		double r[3];
+		double l[3];
+		double c[4];
+		double mass;
+	};
+
+}
+
+class binaryScene {
+	public:
+		binaryScene(robotModel* = 0, obstacleModel* = 0);
+		bool read(const QString&);
+		bool write(const QString&);
+		bool write(QIODevice*);
+
+		std::vector<double> getGrid(void);
+		const std::vector<rsModel::ObstacleSpec>& getObstacles(void);
+		const std::vector<rsModel::RobotSpec>& getRobots(void);
+		quint32 getTag(void);
+		bool getTracking(void);
+		int getVersion(void);
+		void setGrid(const std::vector<double>&);
+		void setObstacles(const std::vector<rsModel::ObstacleSpec>&);
+		void setTag(quint32);
+		void setTracking(bool);
+		void setVersion(int);
+
+		static bool isBinary(const QString&);
+
+	private:
+		bool read_records(const uchar*, qint64);
+
+		robotModel *_model;
+		obstacleModel *_obstacle_model;
+		std::vector<double> _grid;
+		std::vector<rsModel::ObstacleSpec> _obstacles;
+		std::vector<rsModel::RobotSpec> _robots;
+		quint32 _tag;
+		bool _tracking;
+		int _version;
+};
+
+#endif // BINARYSCENE_H_
@@ -0,0 +1,23 @@
+#ifndef IDALLOCATOR_H_
+#define IDALLOCATOR_H_
+
+#include <map>
+
+class idAllocator {
+	public:
+		idAllocator(void);
+
+		int allocate(int = 1);
+		void clear(void);
+		bool isFree(int, int = 1) const;
+		void release(int, int = 1);
+		bool reserve(int, int = 1);
+
+	private:
+		void take(int, int);
+
+		std::map<int, int> _free;		// start -> length of released blocks below _next
+		int _next;
+};
+
+#endif // IDALLOCATOR_H_
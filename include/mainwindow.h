@@ -3,11 +3,18 @@
 
 #include <QMainWindow>
 #include <QFile>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QImage>
 #include <QMessageBox>
 #include <QListView>
 #include <QListWidget>
 
-#include "xmldom.h"
+#include "obstaclemodel.h"
+#include "robotmodel.h"
+#include "scenefile.h"
+#include "scenejournal.h"
+#include "scenewatcher.h"
 
 namespace Ui {
 	class MainWindow;
@@ -22,6 +29,10 @@ class MainWindow : public QMainWindow {
 
 	private slots:
 		void on_pushButton_clicked();
+		void addObstacle(QListWidgetItem*);
+		void iconLoaded(int);
+		void reloaded(const QString&);
+		void save(void);
 
 	private:
 		void build_selector(QListWidget*, QStringList&, QStringList&);
@@ -29,6 +40,13 @@ class MainWindow : public QMainWindow {
 	private:
 		Ui::MainWindow *ui;
 		int _version;
+		QString _file_name;
+		robotModel *_model;
+		obstacleModel *_obstacles;
+		sceneFile *_scene;
+		sceneJournal *_journal;
+		sceneWatcher *_watcher;
+		QHash<QFutureWatcher<QImage>*, QListWidget*> _icon_loaders;
 };
 
 #endif // MAINWINDOW_H
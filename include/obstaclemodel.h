@@ -0,0 +1,95 @@
+#ifndef OBSTACLEMODEL_H
+#define OBSTACLEMODEL_H
+
+#include <vector>
+
+#include <QAbstractTableModel>
+#include <QString>
+
+#include <rs/enum.hpp>
+
+namespace rsModel {
+
+	enum obstacle_item_list {
+		O_TYPE,
+		O_P_X,
+		O_P_Y,
+		O_P_Z,
+		O_R_PHI,
+		O_R_THETA,
+		O_R_PSI,
+		O_L_1,
+		O_L_2,
+		O_L_3,
+		O_C_RED,
+		O_C_GREEN,
+		O_C_BLUE,
+		O_C_ALPHA,
+		O_MASS,
+		NUM_OBSTACLE_COLUMNS
+	};
+
+	// description of one obstacle on the ground
+	struct ObstacleSpec {
+		ObstacleSpec(void) : type(rs::BOX), mass(0) {
+			p[0] = p[1] = p[2] = 0;
+			r[0] = r[1] = r[2] = 0;
+			l[0] = l[1] = l[2] = 0;
+			c[0] = c[1] = c[2] = 0; c[3] = 1;
+		}
+		int type;
+		double p[3];
+		double r[3];		// phi, theta, psi
+		double l[3];		// box x, y, z; radius and length otherwise
+		double c[4];
+		double mass;
+	};
+
+}
+
+/*!
+	Holds the obstacles on the ground. Each row is one ObstacleSpec and
+	each column one of its fields, so the readers, writers and validator
+	use the rows as they are stored.
+*/
+class obstacleModel : public QAbstractTableModel {
+		Q_OBJECT
+	public:
+		obstacleModel(QObject* = 0);
+
+		// for subclassing
+		int columnCount(const QModelIndex &parent = QModelIndex()) const;
+		QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+		QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+		int rowCount(const QModelIndex &parent = QModelIndex()) const;
+
+		// for editing
+		Qt::ItemFlags flags(const QModelIndex&) const;
+		bool setData(const QModelIndex&, const QVariant&, int = Qt::EditRole);
+
+		// for resizing
+		bool insertRows(int row, int count, const QModelIndex &parent = QModelIndex());
+		bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex());
+
+		// typed access without QVariant conversion
+		const rsModel::ObstacleSpec& getObstacle(int) const;
+		const std::vector<rsModel::ObstacleSpec>& getObstacles(void) const;
+		bool setObstacle(int, const rsModel::ObstacleSpec&);
+
+		// bulk insertion with a single notification
+		bool addObstacles(const std::vector<rsModel::ObstacleSpec>&);
+		void setObstacles(const std::vector<rsModel::ObstacleSpec>&);
+
+		static QString typeName(int);
+
+	public slots:
+		bool addObstacle(int = rs::BOX);
+
+	private:
+		static double get_field(const rsModel::ObstacleSpec&, int);
+		static void set_field(rsModel::ObstacleSpec&, int, double);
+
+		std::vector<rsModel::ObstacleSpec> _obstacles;
+};
+
+#endif // OBSTACLEMODEL_H
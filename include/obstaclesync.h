@@ -0,0 +1,71 @@
+#ifndef OBSTACLESYNC_H_
+#define OBSTACLESYNC_H_
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include <QColor>
+#include <QObject>
+#include <QModelIndex>
+#include <QPair>
+#include <QTimer>
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Group>
+
+#include "obstaclemodel.h"
+
+/*!
+	Keeps the scene graph in sync with an obstacleModel. Obstacles are
+	static, so instead of one node per row, all obstacles with the same
+	shape and color are merged into a single geometry in world space.
+	A maze of thousands of walls draws in one call per material. Edits
+	mark the batches they touch, and the batches are rebuilt once the
+	current burst of edits is over.
+*/
+class obstacleSync : public QObject {
+		Q_OBJECT
+	public:
+		obstacleSync(QObject* = 0);
+
+		osg::Group* getRoot(void);
+		void setModel(obstacleModel*);
+		int batchCount(void) const;
+
+	signals:
+		void sceneChanged(void);
+
+	public slots:
+		void dataChanged(const QModelIndex&, const QModelIndex&);
+		void modelReset(void);
+		void rowsInserted(const QModelIndex&, int, int);
+		void rowsRemoved(const QModelIndex&, int, int);
+		void update(void);
+
+	private:
+		typedef QPair<int, QRgb> batchKey;
+
+		// unit shape, tessellated once and copied into each batch
+		struct shapeMesh {
+			std::vector<osg::Vec3> vertices;
+			std::vector<osg::Vec3> normals;
+			std::vector<GLuint> indices;
+		};
+
+		void append(osg::Geometry*, const rsModel::ObstacleSpec&) const;
+		osg::Geometry* create_geometry(const batchKey&) const;
+		void mark(const batchKey&);
+		static batchKey key(const rsModel::ObstacleSpec&);
+		static const shapeMesh& mesh(int);
+
+		obstacleModel *_model;
+		osg::ref_ptr<osg::Group> _root;
+		std::map<batchKey, osg::ref_ptr<osg::Geode> > _batches;
+		std::vector<batchKey> _keys;
+		std::set<batchKey> _dirty;
+		QTimer _timer;
+};
+
+#endif // OBSTACLESYNC_H_
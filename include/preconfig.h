@@ -0,0 +1,40 @@
+#ifndef PRECONFIG_H_
+#define PRECONFIG_H_
+
+#include <rs/enum.hpp>
+
+namespace rsModel {
+
+	enum { MAX_PRECONFIG_MEMBERS = 5, MAX_PRECONFIG_LINKS = 10 };
+
+	// one robot of a preconfiguration, posed relative to its origin
+	struct PreconfigMember {
+		int form;
+		double p[3];		// meters
+		double r[3];		// phi, theta, psi in degrees
+	};
+
+	// connector on a member face, optionally joining it to another member
+	struct PreconfigLink {
+		int member;
+		int face;
+		int conn;			// connector type attached to the face
+		int to_member;		// -1 if the connector joins nothing
+		int to_face;
+	};
+
+	struct PreconfigTemplate {
+		int type;
+		const char *name;
+		int num_members;
+		PreconfigMember members[MAX_PRECONFIG_MEMBERS];
+		int num_links;
+		PreconfigLink links[MAX_PRECONFIG_LINKS];
+	};
+
+	const PreconfigTemplate* preconfigTemplate(int);
+	void preconfigExtent(int, double*, double*);
+
+}
+
+#endif // PRECONFIG_H_
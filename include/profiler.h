@@ -0,0 +1,65 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QString>
+
+/*!
+	Times named phases of startup and counts the heap allocations made
+	during each of them, in bytes rounded up to 16 byte chunks. Only
+	operator new and new[] are counted; memory from malloc(), such as
+	Qt's containers and strings and most of OSG's buffers, is not. Enabled
+	with --profile[=trace.json] on the command line or the
+	ROBOSIM_PROFILE environment variable, which holds 1 or the name of a
+	trace file. Phases nest and must be begun and ended on the GUI
+	thread; allocations are counted on every thread.
+*/
+class profiler {
+	public:
+		static void configure(int, char**);
+		static void enable(const QString& = QString());
+		static bool isEnabled(void);
+
+		static void begin(const char*);
+		static void end(void);
+		static void report(void);
+
+		static void countAllocation(std::size_t);
+
+	private:
+		struct phase {
+			const char *name;
+			int depth;
+			qint64 start, stop;				// nanoseconds since enabled
+			int allocs_start, allocs_stop;
+			qint64 bytes_start, bytes_stop;
+		};
+
+		static bool write_trace(void);
+
+		static bool _enabled;
+		static QString _trace;
+		static QElapsedTimer _timer;
+		static std::vector<phase> _phases;
+		static std::vector<int> _open;
+};
+
+/*!
+	Times the enclosing scope as a profiler phase.
+*/
+class profilePhase {
+	public:
+		profilePhase(const char *name) : _active(profiler::isEnabled()) { if (_active) profiler::begin(name); }
+		~profilePhase(void) { if (_active) profiler::end(); }
+
+	private:
+		profilePhase(const profilePhase&);
+		profilePhase& operator=(const profilePhase&);
+
+		bool _active;
+};
+
+#endif // PROFILER_H_
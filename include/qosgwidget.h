@@ -4,11 +4,17 @@
 #include <iostream>
 #include <vector>
 
+#include <QTimer>
+
 #include <osgQt/GraphicsWindowQt>
 
 #include <rsScene/scene.hpp>
 
+#include "obstaclemodel.h"
+#include "obstaclesync.h"
+#include "robotdragger.h"
 #include "robotmodel.h"
+#include "scenesync.h"
 
 class QOsgWidget : public osgQt::GLWidget, public osgViewer::Viewer {
 	Q_OBJECT
@@ -16,20 +22,33 @@ class QOsgWidget : public osgQt::GLWidget, public osgViewer::Viewer {
 	public:
 		explicit QOsgWidget(QWidget* = 0);
 
+		void setMaxFrameRate(double);
 		void setModel(robotModel*);
+		void setObstacleModel(obstacleModel*);
+		void setRenderOnDemand(bool);
+
+	signals:
+		void indexChanged(const QModelIndex&);
 
 	public slots:
-		void dataChanged(QModelIndex, QModelIndex);
+		void requestRedraw(void);
 		void setCurrentIndex(const QModelIndex&);
 
 	protected:
 		~QOsgWidget();
+		bool event(QEvent*);
+
+	private slots:
+		void render(void);
 
 	private:
 		rsScene::Scene *_scene;
-		robotModel *_model;
-		std::vector<int> _robots;
-		int _current;
+		obstacleSync *_obstacles;
+		sceneSync *_sync;
+		osg::ref_ptr<robotDragger> _dragger;
+		QTimer _timer;
+		bool _dirty;
+		bool _on_demand;
 };
 
 #endif // QOSGWIDGET_H
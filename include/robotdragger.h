@@ -0,0 +1,30 @@
+#ifndef ROBOTDRAGGER_H_
+#define ROBOTDRAGGER_H_
+
+#include <osgGA/GUIEventHandler>
+
+#include "robotmodel.h"
+#include "scenesync.h"
+
+class robotDragger : public osgGA::GUIEventHandler {
+	public:
+		robotDragger(sceneSync*);
+
+		void setModel(robotModel*);
+		bool handle(const osgGA::GUIEventAdapter&, osgGA::GUIActionAdapter&);
+
+	private:
+		bool ground_point(const osgGA::GUIEventAdapter&, osgGA::GUIActionAdapter&, double*, double*) const;
+
+		robotModel *_model;
+		sceneSync *_sync;
+		int _row;
+		bool _rotate;
+		bool _moved;
+		double _start[2];
+		double _p[3];
+		double _r[3];
+		double _x, _y, _psi;
+};
+
+#endif // ROBOTDRAGGER_H_
@@ -2,16 +2,24 @@
 #define ROBOTMODEL_H
 
 #include <iostream>
+#include <map>
 #include <vector>
 
 #include <QAbstractTableModel>
 #include <QVector>
 #include <QStringList>
 #include <QDebug>
+#include <QHash>
 #include <QIcon>
+#include <QPair>
+#include <QPixmap>
 
 #include <rs/enum.hpp>
 
+#include "idallocator.h"
+#include "preconfig.h"
+#include "spatialindex.h"
+
 namespace rsModel {
 
 	enum robot_item_list {
@@ -29,6 +37,26 @@ namespace rsModel {
 		NUM_COLUMNS
 	};
 
+	// columns stored as integers; all others are stored as doubles
+	inline bool isIntColumn(int column) {
+		return (column == ID || column == FORM || column == WHEEL || column == PRECONFIG);
+	}
+
+	// description of one robot row for bulk insertion
+	struct RobotSpec {
+		RobotSpec(void) : id(-1), form(rs::LINKBOTI), radius(0), wheel(0), preconfig(0) {
+			p[0] = p[1] = p[2] = 0;
+			r[0] = r[1] = r[2] = 0;
+		}
+		int id;				// negative to use the next free id
+		int form;
+		double p[3];
+		double r[3];		// phi, theta, psi
+		double radius;
+		int wheel;
+		int preconfig;
+	};
+
 }
 
 class robotModel : public QAbstractTableModel {
@@ -54,6 +82,34 @@ class robotModel : public QAbstractTableModel {
 		// for drag and drop
 		Qt::DropActions supportedDropActions(void) const;
 
+		// typed access without QVariant conversion
+		int getInt(int row, int column) const;
+		double getDouble(int row, int column) const;
+		void getPosition(int row, double *p) const;
+		void getRotation(int row, double *r) const;
+		bool setInt(int row, int column, int value);
+		bool setDouble(int row, int column, double value);
+		int rowForId(int) const;
+
+		// bulk insertion with a single notification
+		bool addRobots(const rsModel::RobotSpec*, int);
+		bool addRobots(const std::vector<rsModel::RobotSpec>&);
+		bool insertRobots(int, const rsModel::RobotSpec*, int);
+
+		// transactions holding back dataChanged()
+		void beginUpdate(void);
+		void endUpdate(void);
+		bool inUpdate(void) const;
+
+		// placement
+		static void getFootprint(const rsModel::RobotSpec&, double*, double*);
+		const spatialIndex* getIndex(void) const;
+
+		// display caches
+		const QString& label(int) const;
+		void setIconSize(const QSize&);
+		QPixmap icon(int, int) const;
+
 		// utility
 		void printModel(void);
 
@@ -64,8 +120,55 @@ class robotModel : public QAbstractTableModel {
 		bool addPreconfig(int = 1, int = Qt::EditRole);
 
 	private:
-		QList<QStringList> _list;
+		void changed(int, int, int, int);
+		void shift_pending(int, int);
+		int id_block(int) const;
+		void insert_rows(int, int);
+		void map_id(int);
+		void map_ids(int, int);
+		bool set_id(int, int, int);
+		void unmap_id(int);
+		static QString icon_file(int, int);
+		void place_robot(rsModel::RobotSpec&) const;
+		void update_index(int);
+		std::vector<int>* int_column(int column);
+		const std::vector<int>* int_column(int column) const;
+		std::vector<double>* double_column(int column);
+		const std::vector<double>* double_column(int column) const;
+
+	private:
+		std::vector<int> _id;
+		std::vector<int> _form;
+		std::vector<int> _wheel;
+		std::vector<int> _preconfig;
+		std::vector<double> _p[3];
+		std::vector<double> _r[3];
+		std::vector<double> _radius;
 		int _l_preconfig[rsLinkbot::NUM_PRECONFIG];
+		mutable std::vector<QString> _labels;
+		mutable QHash<QPair<int, int>, QPixmap> _icons;
+		QSize _icon_size;
+		spatialIndex _index;
+		idAllocator _ids;
+		QHash<int, int> _id_rows;
+		std::map<int, QPair<int, int> > _pending;
+		int _update_depth;
+};
+
+/*!
+	Holds back the notifications of a robotModel for its lifetime, so a
+	group of edits reaches views and the scene as one update.
+*/
+class robotModelUpdate {
+	public:
+		robotModelUpdate(robotModel *model) : _model(model) { _model->beginUpdate(); }
+		~robotModelUpdate(void) { _model->endUpdate(); }
+
+	private:
+		robotModelUpdate(const robotModelUpdate&);
+		robotModelUpdate& operator=(const robotModelUpdate&);
+
+		robotModel *_model;
 };
 
 #endif // ROBOTMODEL_H
@@ -0,0 +1,27 @@
+#ifndef SAVEFILE_H_
+#define SAVEFILE_H_
+
+#include <QFile>
+#include <QString>
+
+/*!
+	Writes a file through a temporary file beside it that replaces the
+	target on commit(), so readers never see a partly written file and a
+	failed save leaves the old file in place. The temporary file is
+	removed if the saveFile is destroyed without a commit.
+*/
+class saveFile : public QFile {
+	public:
+		saveFile(const QString&);
+		~saveFile(void);
+
+		bool open(OpenMode);
+		bool commit(void);
+		QString targetName(void) const;
+
+	private:
+		QString _target;
+		bool _committed;
+};
+
+#endif // SAVEFILE_H_
@@ -0,0 +1,67 @@
+#ifndef SCENEBUILDER_H_
+#define SCENEBUILDER_H_
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <QObject>
+
+#include <OpenThreads/Condition>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Thread>
+
+#include <osg/Group>
+#include <osg/Node>
+#include <osg/ref_ptr>
+
+#include <rsScene/scene.hpp>
+
+#include "preconfig.h"
+
+class sceneBuilder : public OpenThreads::Thread {
+	public:
+		sceneBuilder(QObject* = 0);
+		~sceneBuilder(void);
+
+		// synchronous building
+		void clear(void);
+		osg::Node* getRobot(int, int, int = 0);
+		int getNumPrototypes(void);
+
+		// building on the worker thread
+		void attachFinished(void);
+		void request(osg::Group*, int, int, int = 0);
+
+		static int wheelConnector(int);
+
+	protected:
+		void run(void);
+
+	private:
+		struct buildJob {
+			osg::ref_ptr<osg::Group> parent;
+			osg::ref_ptr<osg::Node> node;
+			int form;
+			int wheel;
+			int preconfig;
+		};
+		typedef std::pair<int, std::pair<int, int> > prototypeKey;
+
+		osg::Node* build_preconfig(int, int);
+		osg::Node* build_robot(int, int);
+		osg::Node* draw_robot(int, int, const double*, const double*, const rsModel::PreconfigTemplate* = NULL, int = -1);
+
+		rsScene::Scene *_scene;
+		std::map<prototypeKey, osg::ref_ptr<osg::Node> > _prototypes;
+		std::vector<rsRobots::Robot*> _robots;
+
+		QObject *_listener;
+		OpenThreads::Mutex _mutex;
+		OpenThreads::Condition _condition;
+		std::vector<buildJob> _pending;
+		std::vector<buildJob> _finished;
+		bool _done;
+};
+
+#endif // SCENEBUILDER_H_
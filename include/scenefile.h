@@ -0,0 +1,52 @@
+#ifndef SCENEFILE_H_
+#define SCENEFILE_H_
+
+#include <vector>
+
+#include <QString>
+
+#include "binaryscene.h"
+#include "obstaclemodel.h"
+#include "robotmodel.h"
+#include "xmlreader.h"
+#include "xmlwriter.h"
+
+namespace rsModel {
+
+	enum scene_format {
+		XML,
+		BINARY
+	};
+
+}
+
+class sceneFile {
+	public:
+		sceneFile(robotModel*, obstacleModel* = 0);
+		bool load(const QString&);
+		bool save(const QString&, int = rsModel::XML);
+
+		std::vector<double> getGrid(void);
+		const std::vector<rsModel::ObstacleSpec>& getObstacles(void);
+		const std::vector<rsModel::RobotSpec>& getRobots(void);
+		const std::vector<rsModel::UnknownElement>& getUnknown(void);
+		bool getTracking(void);
+		int getVersion(void);
+
+		static int format(const QString&);
+
+	private:
+		bool obstacles_changed(void) const;
+
+		robotModel *_model;
+		obstacleModel *_obstacle_model;
+		QString _source;
+		std::vector<double> _grid;
+		std::vector<rsModel::ObstacleSpec> _obstacles;
+		std::vector<rsModel::RobotSpec> _robots;
+		std::vector<rsModel::UnknownElement> _unknown;
+		bool _tracking;
+		int _version;
+};
+
+#endif // SCENEFILE_H_
@@ -0,0 +1,115 @@
+#ifndef SCENEJOURNAL_H_
+#define SCENEJOURNAL_H_
+
+#include <map>
+#include <vector>
+
+#include <QByteArray>
+#include <QFile>
+#include <QModelIndex>
+#include <QObject>
+
+#include <OpenThreads/Condition>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Thread>
+
+#include "robotmodel.h"
+
+namespace rsModel {
+
+	/*
+		On-disk layout of an edit journal, version 2:
+
+			JournalHeader
+			(JournalEntry payload)...
+
+		The journal holds the edits made since its base, which is the
+		snapshot with the same generation or, for generation 0, the
+		scene file itself. Both are only valid for the scene file they
+		were recorded against, identified by its size and modification
+		time. A truncated last entry is ignored.
+	*/
+	struct JournalHeader {
+		char magic[4];			// "RSJL"
+		quint32 version;
+		quint32 byte_order;		// 0x01020304 as written
+		quint32 generation;
+		qint64 base_size;		// size of the scene file
+		qint64 base_mtime;		// modification time of the scene file, in ms
+	};
+
+	enum journal_op {
+		JOURNAL_SET,			// arg is the column, payload one double
+		JOURNAL_INSERT,			// arg is the count, payload count RobotRecords
+		JOURNAL_REMOVE			// arg is the count, no payload
+	};
+
+	struct JournalEntry {
+		qint32 op;
+		qint32 row;
+		qint32 arg;
+		quint32 size;			// bytes of payload following the entry
+	};
+
+}
+
+/*!
+	Keeps an append-only journal of edits to a robot model beside a scene
+	file, so edits survive a crash without rewriting the scene. Edits are
+	encoded on the GUI thread and written by a background thread. Once
+	the journal grows past a limit, the model is copied into a binary
+	snapshot, which the background thread writes before starting the
+	journal over.
+*/
+class sceneJournal : public QObject, public OpenThreads::Thread {
+		Q_OBJECT
+	public:
+		sceneJournal(robotModel*, const QString&, QObject* = 0);
+		~sceneJournal(void);
+
+		bool attach(void);
+		bool replay(void);
+		void setCompactSize(qint64);
+
+	public slots:
+		void clear(void);
+		void compact(void);
+		void dataChanged(const QModelIndex&, const QModelIndex&);
+		void rowsInserted(const QModelIndex&, int, int);
+		void rowsRemoved(const QModelIndex&, int, int);
+
+	protected:
+		void run(void);
+
+	private:
+		void append(const QByteArray&);
+		void base_identity(qint64*, qint64*) const;
+		void replay_journal(quint32*);
+		bool reset_journal(quint32);
+		bool write_snapshot(const QByteArray&, quint32);
+		void shift_inserted(int, int);
+		double value(int, int) const;
+
+		robotModel *_model;
+		QString _file_name;
+		QString _journal_name;
+		QString _snapshot_name;
+		QFile _file;
+		quint32 _generation;
+		qint64 _base_size;
+		qint64 _base_mtime;
+		qint64 _size;
+		qint64 _compact_size;
+		bool _compact_pending;
+		bool _restored;
+		std::map<int, std::vector<double> > _inserted;	// journaled values of rows not yet announced changed
+
+		OpenThreads::Mutex _mutex;			// guards _pending, _snapshot, _done and _generation
+		OpenThreads::Mutex _file_mutex;		// guards _file
+		OpenThreads::Condition _condition;
+		QByteArray _pending;
+		QByteArray _snapshot;				// model of _generation, not yet on disk
+		bool _done;
+};
+
+#endif // SCENEJOURNAL_H_
@@ -0,0 +1,70 @@
+#ifndef SCENESYNC_H_
+#define SCENESYNC_H_
+
+#include <vector>
+
+#include <QObject>
+#include <QModelIndex>
+
+#include <osg/Group>
+#include <osg/PositionAttitudeTransform>
+#include <osgFX/Scribe>
+
+#include "robotmodel.h"
+#include "scenebuilder.h"
+
+class sceneSync : public QObject {
+		Q_OBJECT
+	public:
+		sceneSync(QObject* = 0);
+		~sceneSync(void);
+
+		osg::Group* getRoot(void);
+		void setAsync(bool);
+		void setModel(robotModel*);
+
+		// direct manipulation
+		void pickRobot(int);
+		void previewPose(int, double, double, double);
+
+	signals:
+		void robotPicked(const QModelIndex&);
+		void sceneChanged(void);
+
+	public slots:
+		void dataChanged(const QModelIndex&, const QModelIndex&);
+		void rowsInserted(const QModelIndex&, int, int);
+		void rowsRemoved(const QModelIndex&, int, int);
+		void setCurrentIndex(const QModelIndex&);
+
+	private slots:
+		void robotsBuilt(void);
+
+	private:
+		struct robotNode {
+			robotNode(void) : id(-1), form(-1), wheel(-1), preconfig(-1), radius(0) {}
+			osg::ref_ptr<osg::PositionAttitudeTransform> transform;
+			int id;
+			int form;
+			int wheel;
+			int preconfig;
+			double radius;
+		};
+
+		void build_robot(int);
+		static osg::Vec4 instance_color(int);
+		bool needs_rebuild(int) const;
+		void set_highlight(int, bool);
+		void set_transform(int, const double*, const double*);
+		void update_transform(int);
+
+		sceneBuilder *_builder;
+		robotModel *_model;
+		osg::ref_ptr<osg::Group> _root;
+		osg::ref_ptr<osgFX::Scribe> _highlight;
+		std::vector<robotNode> _nodes;
+		int _current;
+		bool _async;
+};
+
+#endif // SCENESYNC_H_
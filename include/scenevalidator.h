@@ -0,0 +1,97 @@
+#ifndef SCENEVALIDATOR_H_
+#define SCENEVALIDATOR_H_
+
+#include <vector>
+
+#include <QHash>
+#include <QString>
+
+#include "robotmodel.h"
+#include "spatialindex.h"
+#include "xmlreader.h"
+
+namespace rsModel {
+
+	enum diagnostic_check {
+		DUPLICATE_ID,		// value: id, other: first row with the id
+		UNKNOWN_FORM,		// value: form
+		UNDRAWABLE_FORM,	// value: form
+		UNKNOWN_SHAPE,		// value: obstacle type
+		UNKNOWN_ELEMENT,	// row: index into the unknown elements
+		ROBOT_OVERLAP,		// other: robot row
+		OBSTACLE_OVERLAP,	// other: obstacle row
+		OUT_OF_GRID
+	};
+
+	enum diagnostic_target {
+		ROBOT,
+		OBSTACLE,
+		ELEMENT
+	};
+
+	enum diagnostic_severity {
+		SEVERITY_WARNING,
+		SEVERITY_ERROR
+	};
+
+	// one finding of the validator, referring to a row of the scene
+	struct Diagnostic {
+		Diagnostic(void) : check(0), target(0), severity(SEVERITY_ERROR), row(-1), other(-1), value(0) {}
+		int check;
+		int target;
+		int severity;
+		int row;
+		int other;
+		int value;
+	};
+
+}
+
+/*!
+	Checks a scene as read from its file, before the model assigns new ids
+	to duplicates. Robots and obstacles are split into chunks that are
+	checked on the global thread pool against lookup tables and spatial
+	indices built once up front; the diagnostics come back ordered by
+	target and row. The vectors given must live until validate() returns.
+*/
+class sceneValidator {
+	public:
+		sceneValidator(void);
+
+		void setGrid(const std::vector<double>&);
+		void setObstacles(const std::vector<rsModel::ObstacleSpec>&);
+		void setRobots(const std::vector<rsModel::RobotSpec>&);
+		void setUnknown(const std::vector<rsModel::UnknownElement>&);
+		void setChunkSize(int);
+
+		const std::vector<rsModel::Diagnostic>& validate(void);
+		const std::vector<rsModel::Diagnostic>& getDiagnostics(void) const;
+		int errorCount(void) const;
+		QString describe(const rsModel::Diagnostic&) const;
+
+	private:
+		struct chunk {
+			int target;
+			int begin, end;
+		};
+		struct checker;
+		friend struct checker;
+
+		void check_obstacles(const chunk&, std::vector<rsModel::Diagnostic>&) const;
+		void check_robots(const chunk&, std::vector<rsModel::Diagnostic>&) const;
+		bool in_grid(double, double) const;
+		void prepare(void);
+		static void obstacle_footprint(const rsModel::ObstacleSpec&, double*, double*);
+
+		const std::vector<double> *_grid;
+		const std::vector<rsModel::ObstacleSpec> *_obstacles;
+		const std::vector<rsModel::RobotSpec> *_robots;
+		const std::vector<rsModel::UnknownElement> *_unknown;
+		int _chunk_size;
+		QHash<int, int> _first_row;
+		spatialIndex _robot_index;
+		spatialIndex _obstacle_index;
+		std::vector<rsModel::Diagnostic> _diagnostics;
+};
+
+#endif // SCENEVALIDATOR_H_
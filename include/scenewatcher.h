@@ -0,0 +1,50 @@
+#ifndef SCENEWATCHER_H_
+#define SCENEWATCHER_H_
+
+#include <vector>
+
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QTimer>
+
+#include "robotmodel.h"
+
+/*!
+	Follows a scene file on disk and brings the model up to date when it
+	changes. The new robots are matched to the model's rows by id and
+	only the removed, changed and added robots are applied, so views and
+	the scene only update what changed.
+*/
+class sceneWatcher : public QObject {
+		Q_OBJECT
+	public:
+		sceneWatcher(robotModel*, const QString&, QObject* = 0);
+
+		bool isEnabled(void) const;
+		void markSaved(void);
+
+	signals:
+		void reloaded(const QString&);
+
+	public slots:
+		bool reload(void);
+		void setEnabled(bool);
+
+	private slots:
+		void fileChanged(const QString&);
+
+	private:
+		bool apply(const std::vector<rsModel::RobotSpec>&);
+		void file_identity(qint64*, qint64*) const;
+		bool read_robots(std::vector<rsModel::RobotSpec>&);
+
+		robotModel *_model;
+		QString _file_name;
+		QFileSystemWatcher _watcher;
+		QTimer _timer;
+		qint64 _saved_size;
+		qint64 _saved_mtime;
+		bool _enabled;
+};
+
+#endif // SCENEWATCHER_H_
@@ -0,0 +1,53 @@
+#ifndef SPATIALINDEX_H_
+#define SPATIALINDEX_H_
+
+#include <set>
+#include <vector>
+
+#include <QHash>
+#include <QtGlobal>
+
+class spatialIndex {
+	public:
+		spatialIndex(double = 0.2);
+
+		// maintenance
+		void clear(void);
+		void insertRows(int, int);
+		void removeRows(int, int);
+		void update(int, double, double, double, double, double);
+
+		// queries
+		int at(double, double) const;
+		bool nearestFree(double, double, double, double, double, double*, double*) const;
+		std::vector<int> overlapping(int) const;
+		std::vector<int> overlapping(double, double, double, double, double, int = -1) const;
+		std::vector<int> inRegion(double, double, double, double) const;
+		int size(void) const;
+
+	private:
+		struct footprint {
+			footprint(void) : x(0), y(0), hx(0), hy(0), angle(0), extent(0), valid(false) {}
+			double x, y;		// center
+			double hx, hy;		// half extents
+			double angle;		// rotation about z in radians
+			double extent;		// distance from center to corner
+			bool valid;
+		};
+
+		quint64 cell(double, double) const;
+		static quint64 cell_key(qint64, qint64);
+		void cell_insert(int);
+		void cell_remove(int);
+		bool intersects(const footprint&, const footprint&) const;
+		double max_extent(void) const;
+		void rebuild(void);
+		template<class T> void visit(double, double, double, double, T&) const;
+
+		double _cell;
+		std::multiset<double> _extents;		// of valid rows, for the widest footprint
+		std::vector<footprint> _rows;
+		QHash<quint64, std::vector<int> > _cells;
+};
+
+#endif // SPATIALINDEX_H_
@@ -2,30 +2,55 @@
 #define XMLREADER_H
 
 #include <iostream>
+#include <vector>
 
 #include <QFile>
-#include <QMessageBox>
-#include <QTableWidget>
 #include <QXmlStreamReader>
 
+#include "obstaclemodel.h"
+#include "robotmodel.h"
+
+namespace rsModel {
+
+	// element of the ground or sim section that was skipped
+	struct UnknownElement {
+		UnknownElement(void) : line(0) {}
+		QString name;
+		qint64 line;
+	};
+
+}
+
 class xmlReader {
 	public:
-		xmlReader(QTableWidget *table);
+		xmlReader(robotModel* = 0, obstacleModel* = 0);
 		bool read(const QString &fileName);
+		bool read(QIODevice*);
+		QString errorString(void);
+		std::vector<double> getGrid(void);
+		const std::vector<rsModel::ObstacleSpec>& getObstacles(void);
+		const std::vector<rsModel::RobotSpec>& getRobots(void);
+		const std::vector<rsModel::UnknownElement>& getUnknown(void);
+		bool getTracking(void);
 		int getVersion(void);
 	private:
 		void read_config_element(void);
 		void read_ground_element(void);
 		void read_graphics_element(void);
+		void read_obstacle_element(int);
+		void read_robot_element(int, int);
 		void read_sim_element(void);
+		double attribute(const QXmlStreamAttributes&, const char*, double = 0);
 		void skip_unknown_element(void);
 
-		void readBookindexElement();
-		void readEntryElement(QTableWidgetItem *parent);
-		void readPageElement(QTableWidgetItem *parent);
-
-		QTableWidget *_table;
+		robotModel *_model;
+		obstacleModel *_obstacle_model;
 		QXmlStreamReader _reader;
+		std::vector<double> _grid;
+		std::vector<rsModel::ObstacleSpec> _obstacles;
+		std::vector<rsModel::RobotSpec> _robots;
+		std::vector<rsModel::UnknownElement> _unknown;
+		bool _tracking;
 		int _version;
 };
 
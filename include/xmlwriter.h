@@ -0,0 +1,54 @@
+#ifndef XMLWRITER_H
+#define XMLWRITER_H
+
+#include <iostream>
+#include <vector>
+
+#include <QFile>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include "robotmodel.h"
+#include "xmlreader.h"
+
+class xmlWriter {
+	public:
+		xmlWriter(robotModel*);
+		bool write(const QString &fileName);
+		bool write(QIODevice*);
+		void setGrid(const std::vector<double>&);
+		void setObstacles(const std::vector<rsModel::ObstacleSpec>&);
+		void setSource(const QString&);
+		void setTracking(bool);
+		void setVersion(int);
+
+		static QString robotTag(int, int);
+
+	private:
+		enum section {
+			CONFIG = 0x1,
+			GRAPHICS = 0x2,
+			GROUND = 0x4,
+			SIM = 0x8
+		};
+
+		static QString number(double);
+		void copy_element(QXmlStreamReader&);
+		int section_flag(const QStringRef&) const;
+		void write_section(int);
+		void write_config_element(void);
+		void write_graphics_element(void);
+		void write_ground_element(void);
+		void write_sim_element(void);
+
+		robotModel *_model;
+		QXmlStreamWriter _writer;
+		std::vector<double> _grid;
+		std::vector<rsModel::ObstacleSpec> _obstacles;
+		QString _source;
+		int _set;
+		bool _tracking;
+		int _version;
+};
+
+#endif // XMLWRITER_H
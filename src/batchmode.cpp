@@ -0,0 +1,145 @@
+#include <cstring>
+
+#include <osgDB/WriteFile>
+
+#include "batchmode.h"
+
+/*!
+	Parses the command line of a batch run:
+
+		RoboSim --batch [--check] [--format osgt|xml|binary] [--output-dir dir] file...
+
+	Each file is loaded, validated, built into an rsScene graph and
+	written next to the input or into the output directory, without a
+	display or GL context. Scenes with mobots, which have no model to
+	draw, fail for scene graph formats only. With --check the files are
+	only validated.
+*/
+batchMode::batchMode(const QStringList &args) {
+	_format = "osgt";
+	_check = false;
+	_error = false;
+
+	for (int i = 1; i < args.size(); i++) {
+		if (args[i] == "--batch" || args[i] == "--profile" || args[i].startsWith("--profile="))
+			continue;
+		else if (args[i] == "--check")
+			_check = true;
+		else if (args[i] == "--format" && i + 1 < args.size())
+			_format = args[++i];
+		else if (args[i] == "--output-dir" && i + 1 < args.size())
+			_output = args[++i];
+		else if (args[i].startsWith("--"))
+			_error = true;
+		else
+			_files.append(args[i]);
+	}
+	if (_format != "osgt" && _format != "osg" && _format != "ive" && _format != "osgb" &&
+		_format != "xml" && _format != "binary")
+		_error = true;
+}
+
+int batchMode::exec(void) {
+	if (_error || _files.isEmpty()) {
+		this->usage();
+		return 2;
+	}
+
+	int failed = 0;
+	for (int i = 0; i < _files.size(); i++) {
+		if (!this->process(_files[i]))
+			failed++;
+	}
+	std::cerr << _files.size() - failed << " of " << _files.size() << " scenes processed" << std::endl;
+
+	return (failed) ? 1 : 0;
+}
+
+/*!
+	Returns true if the command line asks for a batch run.
+*/
+bool batchMode::requested(int argc, char **argv) {
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--batch"))
+			return true;
+	}
+	return false;
+}
+
+bool batchMode::process(const QString &fileName) {
+	// load scene
+	robotModel model;
+	model.removeRows(0, model.rowCount());
+	obstacleModel obstacles;
+	sceneFile scene(&model, &obstacles);
+	if (!scene.load(fileName)) {
+		std::cerr << qPrintable(fileName) << ": cannot load scene" << std::endl;
+		return false;
+	}
+
+	// check scene
+	if (!this->validate(scene, fileName))
+		return false;
+	if (_check)
+		return true;
+
+	// output file
+	QFileInfo info(fileName);
+	QString dir = (_output.isEmpty()) ? info.absolutePath() : _output;
+	QString suffix = (_format == "binary") ? "rsb" : _format;
+	QString outName = QDir(dir).filePath(info.completeBaseName() + "." + suffix);
+
+	// write scene file
+	if (_format == "xml")
+		return scene.save(outName, rsModel::XML);
+	else if (_format == "binary")
+		return scene.save(outName, rsModel::BINARY);
+
+	// scene graphs cannot show mobots, so leaving them out would lose robots
+	const std::vector<rsModel::RobotSpec> &robots = scene.getRobots();
+	for (unsigned int i = 0; i < robots.size(); i++) {
+		if (robots[i].form == rs::MOBOT) {
+			std::cerr << qPrintable(fileName) << ": robot row " << i << ": error: mobots cannot be drawn into a scene graph" << std::endl;
+			return false;
+		}
+	}
+
+	// build scene graph on this thread and write it
+	sceneSync sync;
+	sync.setAsync(false);
+	sync.setModel(&model);
+	sync.setCurrentIndex(QModelIndex());
+	obstacleSync ground;
+	ground.setModel(&obstacles);
+	ground.update();
+	osg::ref_ptr<osg::Group> root = new osg::Group();
+	root->addChild(ground.getRoot());
+	root->addChild(sync.getRoot());
+	if (!osgDB::writeNodeFile(*root, outName.toStdString())) {
+		std::cerr << qPrintable(outName) << ": cannot write scene graph" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/*!
+	Reports the diagnostics of a scene as read from its file. Only errors
+	fail the scene; overlaps and positions off the grid are warnings.
+*/
+bool batchMode::validate(sceneFile &scene, const QString &fileName) {
+	sceneValidator validator;
+	validator.setRobots(scene.getRobots());
+	validator.setObstacles(scene.getObstacles());
+	std::vector<double> grid = scene.getGrid();
+	validator.setGrid(grid);
+	validator.setUnknown(scene.getUnknown());
+
+	const std::vector<rsModel::Diagnostic> &diagnostics = validator.validate();
+	for (unsigned int i = 0; i < diagnostics.size(); i++)
+		std::cerr << qPrintable(fileName) << ": " << qPrintable(validator.describe(diagnostics[i])) << std::endl;
+	return (validator.errorCount() == 0);
+}
+
+void batchMode::usage(void) {
+	std::cerr << "usage: RoboSim --batch [--check] [--format osgt|osg|osgb|ive|xml|binary] [--output-dir dir] file..." << std::endl;
+}
@@ -0,0 +1,253 @@
+#include <cstring>
+#include <iostream>
+
+#include "binaryscene.h"
+#include "savefile.h"
+
+using namespace rsModel;
+
+namespace {
+	const char magic[4] = {'R', 'S', 'S', 'B'};
+	const quint32 version = 1;
+	const quint32 byte_order = 0x01020304;
+	const int block = 1024;
+
+	// records must keep their documented sizes
+	typedef char robot_record_size_check[(sizeof(RobotRecord) == 72) ? 1 : -1];
+	typedef char obstacle_record_size_check[(sizeof(ObstacleRecord) == 120) ? 1 : -1];
+}
+
+binaryScene::binaryScene(robotModel *model, obstacleModel *obstacles) {
+	_model = model;
+	_obstacle_model = obstacles;
+	_tag = 0;
+	_tracking = false;
+	_version = 0;
+}
+
+/*!
+	Maps a binary scene file into memory and reads its records in place.
+	The robots replace the contents of the model with a single batched
+	insert, and the obstacles those of the obstacle model.
+*/
+bool binaryScene::read(const QString &fileName) {
+	QFile file(fileName);
+	if (!file.open(QFile::ReadOnly)) {
+		std::cerr << "Error: Cannot read file " << qPrintable(fileName)
+				  << ": " << qPrintable(file.errorString())
+				  << std::endl;
+		return false;
+	}
+
+	uchar *data = file.map(0, file.size());
+	if (!data) {
+		std::cerr << "Error: Cannot map file " << qPrintable(fileName) << std::endl;
+		return false;
+	}
+	bool ok = this->read_records(data, file.size());
+	file.unmap(data);
+	if (!ok)
+		std::cerr << "Error: Failed to parse file " << qPrintable(fileName) << std::endl;
+
+	return ok;
+}
+
+/*!
+	Writes the model and scene settings as a binary scene. Records are
+	written in fixed-size blocks straight from the model's typed columns
+	to a temporary file that replaces fileName once it is complete.
+*/
+bool binaryScene::write(const QString &fileName) {
+	saveFile file(fileName);
+	if (!file.open(QFile::WriteOnly)) {
+		std::cerr << "Error: Cannot write file " << qPrintable(fileName)
+				  << ": " << qPrintable(file.errorString())
+				  << std::endl;
+		return false;
+	}
+
+	bool ok = this->write(&file) && file.commit();
+	if (!ok) {
+		std::cerr << "Error: Cannot write file " << qPrintable(fileName)
+				  << ": " << qPrintable(file.errorString())
+				  << std::endl;
+	}
+	return ok;
+}
+
+/*!
+	Writes the scene to an open device, for instance a buffer that is
+	written to disk later.
+*/
+bool binaryScene::write(QIODevice *device) {
+	// header
+	int rows = (_model) ? _model->rowCount() : 0;
+	SceneHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.byte_order = byte_order;
+	header.robot_size = sizeof(RobotRecord);
+	header.obstacle_size = sizeof(ObstacleRecord);
+	header.num_robots = rows;
+	header.num_obstacles = _obstacles.size();
+	header.config_version = _version;
+	header.tracking = _tracking;
+	header.tag = _tag;
+	for (unsigned int i = 0; i < 7 && i < _grid.size(); i++)
+		header.grid[i] = _grid[i];
+	bool ok = (device->write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header));
+
+	// robots
+	std::vector<RobotRecord> records(block);
+	for (int i = 0; ok && i < rows; i += block) {
+		int n = qMin(block, rows - i);
+		for (int j = 0; j < n; j++) {
+			RobotRecord &r = records[j];
+			r.id = _model->getInt(i + j, ID);
+			r.form = _model->getInt(i + j, FORM);
+			_model->getPosition(i + j, r.p);
+			_model->getRotation(i + j, r.r);
+			r.radius = _model->getDouble(i + j, RADIUS);
+			r.wheel = _model->getInt(i + j, WHEEL);
+			r.preconfig = _model->getInt(i + j, PRECONFIG);
+		}
+		qint64 size = n * sizeof(RobotRecord);
+		ok = (device->write(reinterpret_cast<const char*>(&records[0]), size) == size);
+	}
+
+	// obstacles
+	for (unsigned int i = 0; ok && i < _obstacles.size(); i++) {
+		const ObstacleSpec &s = _obstacles[i];
+		ObstacleRecord r;
+		memset(&r, 0, sizeof(r));
+		r.type = s.type;
+		memcpy(r.p, s.p, sizeof(r.p));
+		memcpy(r.r, s.r, sizeof(r.r));
+		memcpy(r.l, s.l, sizeof(r.l));
+		memcpy(r.c, s.c, sizeof(r.c));
+		r.mass = s.mass;
+		ok = (device->write(reinterpret_cast<const char*>(&r), sizeof(r)) == sizeof(r));
+	}
+	return ok;
+}
+
+std::vector<double> binaryScene::getGrid(void) {
+	return _grid;
+}
+
+const std::vector<ObstacleSpec>& binaryScene::getObstacles(void) {
+	return _obstacles;
+}
+
+/*!
+	Returns the robots as stored in the file, before the model assigns
+	free ids to duplicates.
+*/
+const std::vector<RobotSpec>& binaryScene::getRobots(void) {
+	return _robots;
+}
+
+quint32 binaryScene::getTag(void) {
+	return _tag;
+}
+
+bool binaryScene::getTracking(void) {
+	return _tracking;
+}
+
+int binaryScene::getVersion(void) {
+	return _version;
+}
+
+void binaryScene::setGrid(const std::vector<double> &grid) {
+	_grid = grid;
+}
+
+void binaryScene::setObstacles(const std::vector<ObstacleSpec> &obstacles) {
+	_obstacles = obstacles;
+}
+
+void binaryScene::setTag(quint32 tag) {
+	_tag = tag;
+}
+
+void binaryScene::setTracking(bool tracking) {
+	_tracking = tracking;
+}
+
+void binaryScene::setVersion(int version) {
+	_version = version;
+}
+
+/*!
+	Returns true if the file starts with the binary scene magic.
+*/
+bool binaryScene::isBinary(const QString &fileName) {
+	QFile file(fileName);
+	if (!file.open(QFile::ReadOnly))
+		return false;
+	char buf[4];
+	return (file.read(buf, sizeof(buf)) == sizeof(buf) && !memcmp(buf, magic, sizeof(magic)));
+}
+
+bool binaryScene::read_records(const uchar *data, qint64 size) {
+	// check header
+	if (size < static_cast<qint64>(sizeof(SceneHeader)))
+		return false;
+	SceneHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, magic, sizeof(magic)) ||
+		header.version != version ||
+		header.byte_order != byte_order ||
+		header.robot_size != sizeof(RobotRecord) ||
+		header.obstacle_size != sizeof(ObstacleRecord))
+		return false;
+	qint64 expected = sizeof(SceneHeader) + static_cast<qint64>(header.num_robots) * sizeof(RobotRecord)
+					+ static_cast<qint64>(header.num_obstacles) * sizeof(ObstacleRecord);
+	if (size < expected)
+		return false;
+
+	// settings
+	_version = header.config_version;
+	_tracking = header.tracking;
+	_tag = header.tag;
+	_grid.assign(header.grid, header.grid + 7);
+
+	// robots
+	const RobotRecord *robot = reinterpret_cast<const RobotRecord*>(data + sizeof(SceneHeader));
+	_robots.resize(header.num_robots);
+	for (quint32 i = 0; i < header.num_robots; i++) {
+		RobotSpec &s = _robots[i];
+		s.id = robot[i].id;
+		s.form = robot[i].form;
+		memcpy(s.p, robot[i].p, sizeof(s.p));
+		memcpy(s.r, robot[i].r, sizeof(s.r));
+		s.radius = robot[i].radius;
+		s.wheel = robot[i].wheel;
+		s.preconfig = robot[i].preconfig;
+	}
+	if (_model) {
+		if (_model->rowCount())
+			_model->removeRows(0, _model->rowCount());
+		if (!_robots.empty())
+			_model->addRobots(_robots);
+	}
+
+	// obstacles
+	const ObstacleRecord *obstacle = reinterpret_cast<const ObstacleRecord*>(robot + header.num_robots);
+	_obstacles.resize(header.num_obstacles);
+	for (quint32 i = 0; i < header.num_obstacles; i++) {
+		ObstacleSpec &s = _obstacles[i];
+		s.type = obstacle[i].type;
+		memcpy(s.p, obstacle[i].p, sizeof(s.p));
+		memcpy(s.r, obstacle[i].r, sizeof(s.r));
+		memcpy(s.l, obstacle[i].l, sizeof(s.l));
+		memcpy(s.c, obstacle[i].c, sizeof(s.c));
+		s.mass = obstacle[i].mass;
+	}
+	if (_obstacle_model)
+		_obstacle_model->setObstacles(_obstacles);
+
+	return true;
+}
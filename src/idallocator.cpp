@@ -0,0 +1,109 @@
+#include "idallocator.h"
+
+/*!
+	Hands out blocks of consecutive robot ids. New blocks come from the
+	end of the used range in O(1); released blocks are kept in a free
+	list, merged with their neighbours, and reused lowest first.
+*/
+idAllocator::idAllocator(void) {
+	_next = 0;
+}
+
+/*!
+	Returns the first id of a free block of count ids.
+*/
+int idAllocator::allocate(int count) {
+	// reuse a released block
+	for (std::map<int, int>::iterator i = _free.begin(); i != _free.end(); ++i) {
+		if (i->second >= count) {
+			int id = i->first;
+			this->take(id, count);
+			return id;
+		}
+	}
+
+	// extend used range
+	int id = _next;
+	_next += count;
+	return id;
+}
+
+void idAllocator::clear(void) {
+	_free.clear();
+	_next = 0;
+}
+
+/*!
+	Returns true if none of the count ids starting at id are in use.
+*/
+bool idAllocator::isFree(int id, int count) const {
+	if (id < 0) return false;
+	if (id >= _next) return true;
+
+	std::map<int, int>::const_iterator i = _free.upper_bound(id);
+	if (i == _free.begin()) return false;
+	--i;
+	return (id + count <= i->first + i->second);
+}
+
+/*!
+	Returns count ids starting at id to the free list.
+*/
+void idAllocator::release(int id, int count) {
+	if (id < 0 || count <= 0) return;
+
+	// merge with following block
+	std::map<int, int>::iterator next = _free.find(id + count);
+	if (next != _free.end()) {
+		count += next->second;
+		_free.erase(next);
+	}
+
+	// merge with preceding block
+	std::map<int, int>::iterator prev = _free.lower_bound(id);
+	if (prev != _free.begin()) {
+		--prev;
+		if (prev->first + prev->second == id) {
+			id = prev->first;
+			count += prev->second;
+			_free.erase(prev);
+		}
+	}
+
+	// shrink used range or keep for reuse
+	if (id + count >= _next)
+		_next = id;
+	else
+		_free[id] = count;
+}
+
+/*!
+	Marks count ids starting at id as used. Returns false, leaving the
+	allocator unchanged, if any of them is already in use.
+*/
+bool idAllocator::reserve(int id, int count) {
+	if (!this->isFree(id, count)) return false;
+
+	if (id >= _next) {
+		// skipped ids become free; no free block ends at _next
+		if (id > _next) _free[_next] = id - _next;
+		_next = id + count;
+	}
+	else
+		this->take(id, count);
+
+	return true;
+}
+
+/*!
+	Removes count ids starting at id from the free block holding them.
+*/
+void idAllocator::take(int id, int count) {
+	std::map<int, int>::iterator i = _free.upper_bound(id);
+	--i;
+	int start = i->first;
+	int end = start + i->second;
+	_free.erase(i);
+	if (start < id) _free[start] = id - start;
+	if (id + count < end) _free[id + count] = end - id - count;
+}
@@ -1,10 +1,39 @@
+#include "batchmode.h"
 #include "mainwindow.h"
+#include "profiler.h"
 #include <QApplication>
+#include <QCoreApplication>
 
 int main(int argc, char *argv[]) {
+	// time startup phases when asked to
+	profiler::configure(argc, argv);
+
+	// process scenes without a display
+	if (batchMode::requested(argc, argv)) {
+		QCoreApplication a(argc, argv);
+		batchMode batch(a.arguments());
+		int status = 0;
+		{
+			profilePhase phase("batch");
+			status = batch.exec();
+		}
+		profiler::report();
+		return status;
+	}
+
+	profiler::begin("startup");
+	profiler::begin("application");
 	QApplication a(argc, argv);
+	profiler::end();
+	profiler::begin("main window");
 	MainWindow w;
+	profiler::end();
+	profiler::begin("show");
 	w.show();
+	if (profiler::isEnabled()) a.processEvents();
+	profiler::end();
+	profiler::end();
+	profiler::report();
 
 	return a.exec();
 }
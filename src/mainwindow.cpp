@@ -1,26 +1,78 @@
 #include "mainwindow.h"
+#include "profiler.h"
 #include "roboteditor.h"
 #include "robotmodel.h"
 #include "robotview.h"
 #include "ui_mainwindow.h"
 
+#include <QAction>
+#include <QMenu>
+#include <QPainter>
+#include <QtConcurrentMap>
+
+namespace {
+	/*
+		Decodes and scales a palette icon on a worker thread. Only QImage
+		is used here; pixmaps are made on the GUI thread.
+	*/
+	struct iconLoader {
+		typedef QImage result_type;
+		iconLoader(const QSize &size) : _size(size) {}
+		QImage operator()(const QString &fileName) const {
+			QImage image(fileName);
+			if (image.isNull()) return image;
+			return image.scaled(_size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+		}
+		QSize _size;
+	};
+
+	/*
+		Returns the icon shown until a palette icon is loaded.
+	*/
+	QIcon placeholderIcon(const QSize &size) {
+		static QIcon icon;
+		if (icon.isNull() || icon.availableSizes().value(0) != size) {
+			QPixmap pixmap(size);
+			pixmap.fill(Qt::transparent);
+			QPainter painter(&pixmap);
+			painter.setPen(Qt::NoPen);
+			painter.setBrush(QColor(200, 200, 200));
+			painter.drawRoundedRect(pixmap.rect().adjusted(2, 2, -2, -2), 4, 4);
+			icon = QIcon(pixmap);
+		}
+		return icon;
+	}
+}
+
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
+	_model = NULL;
+	_obstacles = NULL;
+	_scene = NULL;
+	_journal = NULL;
+	_watcher = NULL;
+
+	profiler::begin("ui setup");
 	ui = new Ui::MainWindow;
 	ui->setupUi(this);
+	profiler::end();
 
 	// get file
     QString fileName = "/home/kgucwa/projects/playground/RS/RoboSim/robosimrc";
 	if (fileName.isEmpty())
 		return;
 
+	profiler::begin("file check");
 	QFile file(fileName);
-	if (!file.open(QFile::ReadOnly | QFile::Text)) {
+	bool readable = file.open(QFile::ReadOnly);
+	profiler::end();
+	if (!readable) {
 		QMessageBox::warning(this, tr("RoboSim"), tr("Cannot read file %1:\n%2.").arg(fileName));
 		return;
 	}
-	xmlDom xml(fileName);
+	file.close();
 
 	// build robot selector
+	profiler::begin("selectors");
 	QStringList names, icons;
 	names << "Linkbot I" <<  "Linkbot L" << "Mobot" << "NXT";
 	icons << "linkbotI.jpg" << "linkbotL.jpg" << "mobot.jpg" << "mobot.jpg";
@@ -46,38 +98,93 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
 	names << "Line" <<  "Point" << "Text";
 	icons << "line.jpg" << "point.jpg" << "text.jpg";
 	this->build_selector(ui->list_drawings, names, icons);
+	profiler::end();
 
 	// set up robot model
+	profiler::begin("model");
 	robotModel *model = new robotModel(this);
+	_obstacles = new obstacleModel(this);
+	profiler::end();
+
+	// load robots from xml or binary scene file into model
+	profiler::begin("load scene");
+	_model = model;
+	_file_name = fileName;
+	_scene = new sceneFile(model, _obstacles);
+	_scene->load(fileName);
+	_version = _scene->getVersion();
+	profiler::end();
+
+	// restore unsaved edits and keep journaling new ones
+	profiler::begin("journal");
+	_journal = new sceneJournal(model, fileName, this);
+	bool restored = _journal->replay();
+	_journal->attach();
+	profiler::end();
 
 	// set up osg view
+	profiler::begin("osg view");
 	ui->osgWidget->setModel(model);
+	ui->osgWidget->setObstacleModel(_obstacles);
+	profiler::end();
 
 	// set up robot view
+	profiler::begin("robot view");
 	robotView *view = new robotView(model);
 	ui->layout_robots->addWidget(view);
+	profiler::end();
 
 	// set up robot editor
+	profiler::begin("robot editor");
 	robotEditor *editor = new robotEditor(model);
 	ui->layout_robots->addWidget(editor);
+	profiler::end();
 
 	// connect robot pieces together
 	QWidget::connect(ui->pushButton, SIGNAL(clicked()), model, SLOT(addRobot()));
 	QWidget::connect(ui->pushButton_2, SIGNAL(clicked()), model, SLOT(addPreconfig()));
+	QWidget::connect(ui->list_obstacles, SIGNAL(itemActivated(QListWidgetItem*)), this, SLOT(addObstacle(QListWidgetItem*)));
 
 	QWidget::connect(view, SIGNAL(clicked(const QModelIndex&)), editor, SLOT(setCurrentIndex(const QModelIndex&)));
 	QWidget::connect(view, SIGNAL(clicked(const QModelIndex&)), ui->osgWidget, SLOT(setCurrentIndex(const QModelIndex&)));
 	QWidget::connect(editor, SIGNAL(indexChanged(QModelIndex)), view, SLOT(setCurrentIndex(QModelIndex)));
 	QWidget::connect(editor, SIGNAL(indexChanged(QModelIndex)), ui->osgWidget, SLOT(setCurrentIndex(const QModelIndex&)));
+	QWidget::connect(ui->osgWidget, SIGNAL(indexChanged(QModelIndex)), view, SLOT(setCurrentIndex(QModelIndex)));
+	QWidget::connect(ui->osgWidget, SIGNAL(indexChanged(QModelIndex)), editor, SLOT(setCurrentIndex(const QModelIndex&)));
 
 	QWidget::connect(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), editor, SLOT(dataChanged(QModelIndex, QModelIndex)));
-	QWidget::connect(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), ui->osgWidget, SLOT(dataChanged(QModelIndex, QModelIndex)));
+
+	// follow changes made to the scene file by other programs
+	_watcher = new sceneWatcher(model, fileName, this);
+	QWidget::connect(_watcher, SIGNAL(reloaded(const QString&)), _journal, SLOT(clear()));
+	QWidget::connect(_watcher, SIGNAL(reloaded(const QString&)), this, SLOT(reloaded(const QString&)));
+
+	// file menu
+	QMenu *menu = ui->menuBar->addMenu(tr("&File"));
+	QAction *save = menu->addAction(tr("&Save"));
+	save->setShortcut(QKeySequence::Save);
+	QWidget::connect(save, SIGNAL(triggered()), this, SLOT(save()));
+	QAction *follow = menu->addAction(tr("&Follow File Changes"));
+	follow->setCheckable(true);
+	QWidget::connect(follow, SIGNAL(toggled(bool)), _watcher, SLOT(setEnabled(bool)));
+	follow->setChecked(QCoreApplication::arguments().contains("--watch"));
 
 	// parsing of xml complete
-	ui->statusBar->showMessage(tr("Loaded %1").arg(fileName), 2000);
+	if (restored)
+		ui->statusBar->showMessage(tr("Loaded %1 with unsaved edits restored").arg(fileName), 2000);
+	else
+		ui->statusBar->showMessage(tr("Loaded %1").arg(fileName), 2000);
 }
 
 MainWindow::~MainWindow(void) {
+	// stop loading icons for widgets about to go away
+	QHash<QFutureWatcher<QImage>*, QListWidget*>::iterator i;
+	for (i = _icon_loaders.begin(); i != _icon_loaders.end(); ++i) {
+		i.key()->disconnect(this);
+		i.key()->cancel();
+		i.key()->waitForFinished();
+	}
+	delete _scene;
 	delete ui;
 }
 
@@ -86,12 +193,67 @@ void MainWindow::on_pushButton_clicked()
 	std::cerr << "pushbutton clicked" << std::endl;
 }
 
+/*!
+	Adds the obstacle activated in the palette.
+*/
+void MainWindow::addObstacle(QListWidgetItem *item) {
+	static const int types[3] = {rs::BOX, rs::CYLINDER, rs::SPHERE};
+	int row = ui->list_obstacles->row(item);
+	if (row >= 0 && row < 3)
+		_obstacles->addObstacle(types[row]);
+}
+
+/*!
+	Saves the scene over the file it was loaded from, in the same format,
+	and drops the autosave journal it supersedes.
+*/
+void MainWindow::save(void) {
+	if (!_scene) return;
+
+	if (!_scene->save(_file_name, sceneFile::format(_file_name))) {
+		QMessageBox::warning(this, tr("RoboSim"), tr("Cannot write file %1.").arg(_file_name));
+		return;
+	}
+	if (_watcher) _watcher->markSaved();
+	if (_journal) _journal->clear();
+	ui->statusBar->showMessage(tr("Saved %1").arg(_file_name), 2000);
+}
+
+void MainWindow::reloaded(const QString &fileName) {
+	ui->statusBar->showMessage(tr("Reloaded %1").arg(fileName), 2000);
+}
+
+/*!
+	Fills a palette with one item per name. Items show a placeholder icon
+	at once, and their images are decoded on worker threads and set by
+	iconLoaded() as they arrive.
+*/
 void MainWindow::build_selector(QListWidget *widget, QStringList &names, QStringList &icons) {
+	QSize size = widget->iconSize();
+	if (!size.isValid()) size = QSize(48, 48);
+
 	for (int i = 0; i < names.size(); i++) {
 		QListWidgetItem *button = new QListWidgetItem(widget);
-		button->setIcon(QIcon(icons[i]));
+		button->setIcon(placeholderIcon(size));
 		button->setText(names[i]);
 		button->setTextAlignment(Qt::AlignCenter);
 		button->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsDragEnabled);
 	}
+
+	// load icons in the background
+	QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+	_icon_loaders.insert(watcher, widget);
+	QObject::connect(watcher, SIGNAL(resultReadyAt(int)), this, SLOT(iconLoaded(int)));
+	watcher->setFuture(QtConcurrent::mapped(icons, iconLoader(size)));
+}
+
+void MainWindow::iconLoaded(int index) {
+	QFutureWatcher<QImage> *watcher = static_cast<QFutureWatcher<QImage>*>(this->sender());
+	QListWidget *widget = _icon_loaders.value(watcher);
+	if (!widget || index >= widget->count()) return;
+
+	// keep the placeholder for missing images
+	QImage image = watcher->resultAt(index);
+	if (!image.isNull())
+		widget->item(index)->setIcon(QIcon(QPixmap::fromImage(image)));
 }
@@ -0,0 +1,206 @@
+#include "obstaclemodel.h"
+
+using namespace rsModel;
+
+obstacleModel::obstacleModel(QObject *parent) : QAbstractTableModel(parent) {
+}
+
+/*!
+	Adds an obstacle of the given type resting on the ground, 6 inches
+	past the last obstacle.
+*/
+bool obstacleModel::addObstacle(int type) {
+	ObstacleSpec spec;
+	spec.type = type;
+	spec.c[2] = 1;
+	switch (type) {
+		case rs::BOX:
+			spec.l[0] = spec.l[1] = spec.l[2] = 0.1;
+			spec.p[2] = 0.05;
+			break;
+		case rs::CYLINDER:
+			spec.l[0] = 0.05;
+			spec.l[1] = 0.1;
+			spec.p[2] = 0.05;
+			break;
+		case rs::SPHERE:
+			spec.l[0] = 0.05;
+			spec.p[2] = 0.05;
+			break;
+		default:
+			return false;
+	}
+	spec.p[0] = (_obstacles.empty()) ? 0.2 : _obstacles.back().p[0] + 0.1524;
+	spec.p[1] = (_obstacles.empty()) ? 0.2 : _obstacles.back().p[1];
+
+	std::vector<ObstacleSpec> specs(1, spec);
+	return this->addObstacles(specs);
+}
+
+/*!
+	Appends obstacles with a single beginInsertRows()/endInsertRows()
+	pair.
+*/
+bool obstacleModel::addObstacles(const std::vector<ObstacleSpec> &specs) {
+	if (specs.empty()) return false;
+
+	beginInsertRows(QModelIndex(), _obstacles.size(), _obstacles.size() + specs.size() - 1);
+	_obstacles.insert(_obstacles.end(), specs.begin(), specs.end());
+	endInsertRows();
+	return true;
+}
+
+/*!
+	Replaces all obstacles with a single model reset.
+*/
+void obstacleModel::setObstacles(const std::vector<ObstacleSpec> &specs) {
+	beginResetModel();
+	_obstacles = specs;
+	endResetModel();
+}
+
+const ObstacleSpec& obstacleModel::getObstacle(int row) const {
+	return _obstacles[row];
+}
+
+const std::vector<ObstacleSpec>& obstacleModel::getObstacles(void) const {
+	return _obstacles;
+}
+
+/*!
+	Replaces one obstacle and emits dataChanged() for its row.
+*/
+bool obstacleModel::setObstacle(int row, const ObstacleSpec &spec) {
+	if (row < 0 || row >= this->rowCount()) return false;
+	_obstacles[row] = spec;
+	emit dataChanged(createIndex(row, 0), createIndex(row, NUM_OBSTACLE_COLUMNS-1));
+	return true;
+}
+
+/*!
+	Returns a display name for an obstacle type.
+*/
+QString obstacleModel::typeName(int type) {
+	switch (type) {
+		case rs::BOX: return tr("Box");
+		case rs::CYLINDER: return tr("Cylinder");
+		case rs::SPHERE: return tr("Sphere");
+		default: return tr("Obstacle");
+	}
+}
+
+int obstacleModel::columnCount(const QModelIndex&) const {
+	return NUM_OBSTACLE_COLUMNS;
+}
+
+int obstacleModel::rowCount(const QModelIndex&) const {
+	return _obstacles.size();
+}
+
+QVariant obstacleModel::data(const QModelIndex &index, int role) const {
+	if (!index.isValid() || index.row() >= this->rowCount())
+		return QVariant();
+
+	const ObstacleSpec &spec = _obstacles[index.row()];
+	if (role == Qt::DisplayRole) {
+		if (index.column() == O_TYPE)
+			return obstacleModel::typeName(spec.type);
+		return obstacleModel::get_field(spec, index.column());
+	}
+	else if (role == Qt::EditRole) {
+		if (index.column() == O_TYPE)
+			return spec.type;
+		return obstacleModel::get_field(spec, index.column());
+	}
+	return QVariant();
+}
+
+QVariant obstacleModel::headerData(int section, Qt::Orientation orientation, int role) const {
+	if (role != Qt::DisplayRole)
+		return QVariant();
+
+	if (orientation == Qt::Horizontal)
+		return QString("Column %1").arg(section);
+	else
+		return QString("Row %1").arg(section);
+}
+
+Qt::ItemFlags obstacleModel::flags(const QModelIndex &index) const {
+	if (!index.isValid())
+		return Qt::ItemIsEnabled;
+
+	return QAbstractItemModel::flags(index) | Qt::ItemIsEditable;
+}
+
+bool obstacleModel::setData(const QModelIndex &index, const QVariant &value, int role) {
+	if (!index.isValid() || role != Qt::EditRole || index.row() >= this->rowCount())
+		return false;
+
+	ObstacleSpec &spec = _obstacles[index.row()];
+	if (index.column() == O_TYPE)
+		spec.type = value.toInt();
+	else
+		obstacleModel::set_field(spec, index.column(), value.toDouble());
+	emit dataChanged(index, index);
+	return true;
+}
+
+/*!
+	Inserts count boxes at row.
+*/
+bool obstacleModel::insertRows(int row, int count, const QModelIndex &parent) {
+	if (count <= 0 || row < 0 || row > this->rowCount()) return false;
+
+	beginInsertRows(parent, row, row + count - 1);
+	_obstacles.insert(_obstacles.begin() + row, count, ObstacleSpec());
+	endInsertRows();
+	return true;
+}
+
+bool obstacleModel::removeRows(int row, int count, const QModelIndex &parent) {
+	if (count <= 0 || row < 0 || row + count > this->rowCount()) return false;
+
+	beginRemoveRows(parent, row, row + count - 1);
+	_obstacles.erase(_obstacles.begin() + row, _obstacles.begin() + row + count);
+	endRemoveRows();
+	return true;
+}
+
+/*!
+	Returns the double field of an obstacle stored in a column other than
+	the type.
+*/
+double obstacleModel::get_field(const ObstacleSpec &spec, int column) {
+	switch (column) {
+		case O_P_X: case O_P_Y: case O_P_Z:
+			return spec.p[column - O_P_X];
+		case O_R_PHI: case O_R_THETA: case O_R_PSI:
+			return spec.r[column - O_R_PHI];
+		case O_L_1: case O_L_2: case O_L_3:
+			return spec.l[column - O_L_1];
+		case O_C_RED: case O_C_GREEN: case O_C_BLUE: case O_C_ALPHA:
+			return spec.c[column - O_C_RED];
+		default:
+			return spec.mass;
+	}
+}
+
+void obstacleModel::set_field(ObstacleSpec &spec, int column, double value) {
+	switch (column) {
+		case O_P_X: case O_P_Y: case O_P_Z:
+			spec.p[column - O_P_X] = value;
+			break;
+		case O_R_PHI: case O_R_THETA: case O_R_PSI:
+			spec.r[column - O_R_PHI] = value;
+			break;
+		case O_L_1: case O_L_2: case O_L_3:
+			spec.l[column - O_L_1] = value;
+			break;
+		case O_C_RED: case O_C_GREEN: case O_C_BLUE: case O_C_ALPHA:
+			spec.c[column - O_C_RED] = value;
+			break;
+		default:
+			spec.mass = value;
+			break;
+	}
+}
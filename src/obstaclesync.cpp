@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <cmath>
+
+#include <osg/BlendFunc>
+#include <osg/Material>
+#include <osg/Math>
+#include <osg/Quat>
+
+#include "obstaclesync.h"
+
+using namespace rsModel;
+
+namespace {
+	const double DEG2RAD = 0.017453292519943295;
+	const int SEGMENTS = 24;		// around cylinders and spheres
+	const int RINGS = 12;			// from pole to pole of spheres
+}
+
+obstacleSync::obstacleSync(QObject *parent) : QObject(parent) {
+	_model = NULL;
+
+	// root of all obstacle batches, colored by their color arrays
+	_root = new osg::Group();
+	osg::Material *material = new osg::Material();
+	material->setColorMode(osg::Material::AMBIENT_AND_DIFFUSE);
+	_root->getOrCreateStateSet()->setAttribute(material);
+
+	// rebuild batches once a burst of edits is over
+	_timer.setSingleShot(true);
+	_timer.setInterval(0);
+	QObject::connect(&_timer, SIGNAL(timeout()), this, SLOT(update()));
+}
+
+osg::Group* obstacleSync::getRoot(void) {
+	return _root.get();
+}
+
+void obstacleSync::setModel(obstacleModel *model) {
+	if (_model) _model->disconnect(this);
+	_model = model;
+
+	// follow model changes
+	QObject::connect(_model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SLOT(dataChanged(const QModelIndex&, const QModelIndex&)));
+	QObject::connect(_model, SIGNAL(modelReset()), this, SLOT(modelReset()));
+	QObject::connect(_model, SIGNAL(rowsInserted(QModelIndex, int, int)), this, SLOT(rowsInserted(const QModelIndex&, int, int)));
+	QObject::connect(_model, SIGNAL(rowsRemoved(QModelIndex, int, int)), this, SLOT(rowsRemoved(const QModelIndex&, int, int)));
+
+	// draw obstacles already in the model
+	this->modelReset();
+}
+
+/*!
+	Returns the number of merged geometries, which is the number of draw
+	calls spent on obstacles.
+*/
+int obstacleSync::batchCount(void) const {
+	return _batches.size();
+}
+
+void obstacleSync::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+	for (int i = topLeft.row(); i <= bottomRight.row() && i < static_cast<int>(_keys.size()); i++) {
+		// the row leaves its old batch and joins its new one
+		this->mark(_keys[i]);
+		_keys[i] = obstacleSync::key(_model->getObstacle(i));
+		this->mark(_keys[i]);
+	}
+}
+
+void obstacleSync::modelReset(void) {
+	for (unsigned int i = 0; i < _keys.size(); i++)
+		this->mark(_keys[i]);
+	_keys.resize(_model->rowCount());
+	for (unsigned int i = 0; i < _keys.size(); i++) {
+		_keys[i] = obstacleSync::key(_model->getObstacle(i));
+		this->mark(_keys[i]);
+	}
+}
+
+void obstacleSync::rowsInserted(const QModelIndex&, int first, int last) {
+	_keys.insert(_keys.begin() + first, last - first + 1, batchKey());
+	for (int i = first; i <= last; i++) {
+		_keys[i] = obstacleSync::key(_model->getObstacle(i));
+		this->mark(_keys[i]);
+	}
+}
+
+void obstacleSync::rowsRemoved(const QModelIndex&, int first, int last) {
+	for (int i = first; i <= last; i++)
+		this->mark(_keys[i]);
+	_keys.erase(_keys.begin() + first, _keys.begin() + last + 1);
+}
+
+/*!
+	Rebuilds the batches marked since the last update in one pass over
+	the model. Batches left empty are removed from the scene.
+*/
+void obstacleSync::update(void) {
+	_timer.stop();
+	if (_dirty.empty() || !_model) return;
+
+	// fill new geometry for every dirty batch
+	std::map<batchKey, osg::ref_ptr<osg::Geometry> > geometry;
+	std::set<batchKey>::const_iterator k;
+	for (k = _dirty.begin(); k != _dirty.end(); ++k)
+		geometry[*k] = this->create_geometry(*k);
+	const std::vector<ObstacleSpec> &obstacles = _model->getObstacles();
+	for (unsigned int i = 0; i < obstacles.size(); i++) {
+		if (_dirty.count(_keys[i]))
+			this->append(geometry[_keys[i]].get(), obstacles[i]);
+	}
+
+	// swap them into the scene
+	std::map<batchKey, osg::ref_ptr<osg::Geometry> >::iterator g;
+	for (g = geometry.begin(); g != geometry.end(); ++g) {
+		osg::ref_ptr<osg::Geode> &geode = _batches[g->first];
+		if (g->second->getVertexArray()->getNumElements() == 0) {
+			if (geode.valid()) _root->removeChild(geode.get());
+			_batches.erase(g->first);
+			continue;
+		}
+		if (!geode.valid()) {
+			geode = new osg::Geode();
+			_root->addChild(geode.get());
+		}
+		geode->removeDrawables(0, geode->getNumDrawables());
+		g->second->dirtyBound();
+		geode->addDrawable(g->second.get());
+	}
+	_dirty.clear();
+
+	// signal redraw
+	emit sceneChanged();
+}
+
+/*!
+	Appends an obstacle to a batch. The unit shape is scaled to the
+	obstacle's size, rotated and moved into world space. Scaling a box
+	along its axes or a cylinder or sphere evenly about its axis keeps
+	the unit normals, so they are only rotated.
+*/
+void obstacleSync::append(osg::Geometry *geometry, const ObstacleSpec &o) const {
+	if (o.type != rs::BOX && o.type != rs::CYLINDER && o.type != rs::SPHERE) return;
+
+	const shapeMesh &m = obstacleSync::mesh(o.type);
+	osg::Vec3 scale;
+	switch (o.type) {
+		case rs::BOX:		scale.set(o.l[0], o.l[1], o.l[2]); break;
+		case rs::CYLINDER:	scale.set(o.l[0], o.l[0], o.l[1]); break;
+		default:			scale.set(o.l[0], o.l[0], o.l[0]); break;
+	}
+	osg::Quat q(o.r[0]*DEG2RAD, osg::Vec3d(1, 0, 0),
+				o.r[1]*DEG2RAD, osg::Vec3d(0, 1, 0),
+				o.r[2]*DEG2RAD, osg::Vec3d(0, 0, 1));
+	osg::Vec3 p(o.p[0], o.p[1], o.p[2]);
+
+	osg::Vec3Array *vertices = static_cast<osg::Vec3Array*>(geometry->getVertexArray());
+	osg::Vec3Array *normals = static_cast<osg::Vec3Array*>(geometry->getNormalArray());
+	osg::DrawElementsUInt *indices = static_cast<osg::DrawElementsUInt*>(geometry->getPrimitiveSet(0));
+	GLuint base = vertices->size();
+	for (unsigned int i = 0; i < m.vertices.size(); i++) {
+		const osg::Vec3 &v = m.vertices[i];
+		vertices->push_back(q*osg::Vec3(v.x()*scale.x(), v.y()*scale.y(), v.z()*scale.z()) + p);
+		normals->push_back(q*m.normals[i]);
+	}
+	for (unsigned int i = 0; i < m.indices.size(); i++)
+		indices->push_back(base + m.indices[i]);
+}
+
+/*!
+	Creates an empty batch drawn in the color of its key. Batches are
+	drawn from vertex buffers, and translucent ones are sorted with the
+	other transparent geometry.
+*/
+osg::Geometry* obstacleSync::create_geometry(const batchKey &key) const {
+	osg::Geometry *geometry = new osg::Geometry();
+	geometry->setUseDisplayList(false);
+	geometry->setUseVertexBufferObjects(true);
+	geometry->setVertexArray(new osg::Vec3Array());
+	geometry->setNormalArray(new osg::Vec3Array());
+	geometry->setNormalBinding(osg::Geometry::BIND_PER_VERTEX);
+	geometry->addPrimitiveSet(new osg::DrawElementsUInt(GL_TRIANGLES));
+
+	QColor c = QColor::fromRgba(key.second);
+	osg::Vec4Array *colors = new osg::Vec4Array();
+	colors->push_back(osg::Vec4(c.redF(), c.greenF(), c.blueF(), c.alphaF()));
+	geometry->setColorArray(colors);
+	geometry->setColorBinding(osg::Geometry::BIND_OVERALL);
+
+	if (c.alpha() < 255) {
+		osg::StateSet *state = geometry->getOrCreateStateSet();
+		state->setAttributeAndModes(new osg::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+		state->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+	}
+	return geometry;
+}
+
+void obstacleSync::mark(const batchKey &key) {
+	_dirty.insert(key);
+	if (!_timer.isActive()) _timer.start();
+}
+
+/*!
+	Returns the batch of an obstacle: its shape and its color rounded to
+	eight bits per channel.
+*/
+obstacleSync::batchKey obstacleSync::key(const ObstacleSpec &o) {
+	QColor c;
+	c.setRgbF(qBound(0.0, o.c[0], 1.0), qBound(0.0, o.c[1], 1.0), qBound(0.0, o.c[2], 1.0), qBound(0.0, o.c[3], 1.0));
+	return batchKey(o.type, c.rgba());
+}
+
+/*!
+	Returns the unit mesh of a shape: a box with sides of one, or a
+	cylinder or sphere of radius one. Cylinders have a length of one
+	along z.
+*/
+const obstacleSync::shapeMesh& obstacleSync::mesh(int type) {
+	static shapeMesh box, cylinder, sphere;
+
+	if (type == rs::BOX) {
+		if (box.vertices.empty()) {
+			// one quad per face so each face has its own normal
+			for (int axis = 0; axis < 3; axis++) {
+				for (int side = -1; side <= 1; side += 2) {
+					osg::Vec3 n;
+					n[axis] = side;
+					osg::Vec3 u, v;
+					u[(axis + 1) % 3] = 0.5;
+					v[(axis + 2) % 3] = 0.5;
+					if (side < 0) std::swap(u, v);
+					osg::Vec3 c = n*0.5;
+					GLuint base = box.vertices.size();
+					box.vertices.push_back(c - u - v);
+					box.vertices.push_back(c + u - v);
+					box.vertices.push_back(c + u + v);
+					box.vertices.push_back(c - u + v);
+					for (int i = 0; i < 4; i++) box.normals.push_back(n);
+					GLuint quad[6] = {0, 1, 2, 0, 2, 3};
+					for (int i = 0; i < 6; i++) box.indices.push_back(base + quad[i]);
+				}
+			}
+		}
+		return box;
+	}
+	else if (type == rs::CYLINDER) {
+		if (cylinder.vertices.empty()) {
+			// side
+			for (int i = 0; i <= SEGMENTS; i++) {
+				double a = 2*osg::PI*i/SEGMENTS;
+				osg::Vec3 n(cos(a), sin(a), 0);
+				cylinder.vertices.push_back(n + osg::Vec3(0, 0, -0.5));
+				cylinder.vertices.push_back(n + osg::Vec3(0, 0, 0.5));
+				cylinder.normals.push_back(n);
+				cylinder.normals.push_back(n);
+			}
+			for (int i = 0; i < SEGMENTS; i++) {
+				GLuint quad[6] = {2*i, 2*i + 2, 2*i + 3, 2*i, 2*i + 3, 2*i + 1};
+				for (int j = 0; j < 6; j++) cylinder.indices.push_back(quad[j]);
+			}
+			// caps
+			for (int side = -1; side <= 1; side += 2) {
+				GLuint center = cylinder.vertices.size();
+				cylinder.vertices.push_back(osg::Vec3(0, 0, 0.5*side));
+				cylinder.normals.push_back(osg::Vec3(0, 0, side));
+				for (int i = 0; i < SEGMENTS; i++) {
+					double a = 2*osg::PI*i/SEGMENTS;
+					cylinder.vertices.push_back(osg::Vec3(cos(a), sin(a), 0.5*side));
+					cylinder.normals.push_back(osg::Vec3(0, 0, side));
+				}
+				for (int i = 0; i < SEGMENTS; i++) {
+					GLuint a = center + 1 + i, b = center + 1 + (i + 1) % SEGMENTS;
+					cylinder.indices.push_back(center);
+					cylinder.indices.push_back((side > 0) ? a : b);
+					cylinder.indices.push_back((side > 0) ? b : a);
+				}
+			}
+		}
+		return cylinder;
+	}
+
+	if (sphere.vertices.empty()) {
+		for (int i = 0; i <= RINGS; i++) {
+			double theta = osg::PI*i/RINGS;
+			for (int j = 0; j <= SEGMENTS; j++) {
+				double phi = 2*osg::PI*j/SEGMENTS;
+				osg::Vec3 n(sin(theta)*cos(phi), sin(theta)*sin(phi), cos(theta));
+				sphere.vertices.push_back(n);
+				sphere.normals.push_back(n);
+			}
+		}
+		for (int i = 0; i < RINGS; i++) {
+			for (int j = 0; j < SEGMENTS; j++) {
+				GLuint a = i*(SEGMENTS + 1) + j, b = a + SEGMENTS + 1;
+				GLuint quad[6] = {a, b, b + 1, a, b + 1, a + 1};
+				for (int k = 0; k < 6; k++) sphere.indices.push_back(quad[k]);
+			}
+		}
+	}
+	return sphere;
+}
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cmath>
+
+#include "preconfig.h"
+
+using namespace rsModel;
+
+namespace {
+	/*
+		Templates for the Linkbot preconfigurations. Faces are numbered as
+		in robosimrc files: 1 and 3 are the wheel faces, 2 the front face.
+		The table is constant data and is laid out at compile time.
+	*/
+	const PreconfigTemplate templates[] = {
+		{	rsLinkbot::BOW, "Bow", 2,
+			{	{rs::LINKBOTL, {0, 0, 0}, {0, 0, 0}},
+				{rs::LINKBOTL, {0.1, 0, 0}, {0, 0, 180}} },
+			1,
+			{	{0, 2, rs::SIMPLE, 1, 2} }
+		},
+		{	rsLinkbot::EXPLORER, "Explorer", 5,
+			{	{rs::LINKBOTI, {0, 0, 0}, {0, 0, 0}},
+				{rs::LINKBOTL, {0, -0.09, 0.04}, {0, 0, 0}},
+				{rs::LINKBOTL, {0, -0.18, 0.08}, {0, 0, 0}},
+				{rs::LINKBOTI, {0, -0.27, 0}, {0, 0, 0}},
+				{rs::LINKBOTL, {0, -0.36, 0.04}, {0, 0, 180}} },
+			8,
+			{	{0, 1, rs::SMALLWHEEL, -1, 0},
+				{0, 3, rs::SMALLWHEEL, -1, 0},
+				{0, 2, rs::SIMPLE, 1, 1},
+				{1, 2, rs::SIMPLE, 2, 1},
+				{2, 2, rs::SIMPLE, 3, 2},
+				{3, 1, rs::SMALLWHEEL, -1, 0},
+				{3, 3, rs::SMALLWHEEL, -1, 0},
+				{4, 1, rs::SIMPLE, 2, 3} }
+		},
+		{	rsLinkbot::FOURBOTDRIVE, "Four Bot Drive", 4,
+			{	{rs::LINKBOTI, {-0.06, -0.06, 0}, {0, 0, 0}},
+				{rs::LINKBOTI, {0.06, -0.06, 0}, {0, 0, 0}},
+				{rs::LINKBOTI, {-0.06, 0.06, 0}, {0, 0, 180}},
+				{rs::LINKBOTI, {0.06, 0.06, 0}, {0, 0, 180}} },
+			8,
+			{	{0, 1, rs::SMALLWHEEL, -1, 0},
+				{0, 2, rs::SIMPLE, 2, 2},
+				{1, 3, rs::SMALLWHEEL, -1, 0},
+				{1, 2, rs::SIMPLE, 3, 2},
+				{2, 3, rs::SMALLWHEEL, -1, 0},
+				{3, 1, rs::SMALLWHEEL, -1, 0},
+				{0, 3, rs::SIMPLE, 1, 1},
+				{2, 1, rs::SIMPLE, 3, 3} }
+		},
+		{	rsLinkbot::FOURWHEELDRIVE, "Four Wheel Drive", 4,
+			{	{rs::LINKBOTI, {0, -0.05, 0}, {0, 0, 0}},
+				{rs::LINKBOTI, {0, 0.05, 0}, {0, 0, 180}},
+				{rs::LINKBOTL, {-0.09, 0, 0.04}, {0, 0, 90}},
+				{rs::LINKBOTL, {0.09, 0, 0.04}, {0, 0, -90}} },
+			6,
+			{	{0, 1, rs::SMALLWHEEL, -1, 0},
+				{0, 3, rs::SMALLWHEEL, -1, 0},
+				{1, 1, rs::SMALLWHEEL, -1, 0},
+				{1, 3, rs::SMALLWHEEL, -1, 0},
+				{0, 2, rs::SIMPLE, 1, 2},
+				{2, 2, rs::SIMPLE, 3, 2} }
+		},
+		{	rsLinkbot::FOURWHEELEXPLORER, "Four Wheel Explorer", 5,
+			{	{rs::LINKBOTI, {0, -0.05, 0}, {0, 0, 0}},
+				{rs::LINKBOTI, {0, 0.05, 0}, {0, 0, 180}},
+				{rs::LINKBOTL, {0, 0, 0.09}, {0, 0, 0}},
+				{rs::LINKBOTL, {0, -0.09, 0.13}, {0, 0, 0}},
+				{rs::LINKBOTI, {0, -0.18, 0.13}, {0, 0, 0}} },
+			8,
+			{	{0, 1, rs::SMALLWHEEL, -1, 0},
+				{0, 3, rs::SMALLWHEEL, -1, 0},
+				{1, 1, rs::SMALLWHEEL, -1, 0},
+				{1, 3, rs::SMALLWHEEL, -1, 0},
+				{0, 2, rs::SIMPLE, 1, 2},
+				{2, 1, rs::SIMPLE, 0, 2},
+				{2, 2, rs::SIMPLE, 3, 1},
+				{3, 2, rs::SIMPLE, 4, 2} }
+		},
+		{	rsLinkbot::GROUPBOW, "Group Bow", 4,
+			{	{rs::LINKBOTL, {0, 0, 0}, {0, 0, 0}},
+				{rs::LINKBOTL, {0.1, 0, 0}, {0, 0, 180}},
+				{rs::LINKBOTL, {0, 0.12, 0}, {0, 0, 0}},
+				{rs::LINKBOTL, {0.1, 0.12, 0}, {0, 0, 180}} },
+			2,
+			{	{0, 2, rs::SIMPLE, 1, 2},
+				{2, 2, rs::SIMPLE, 3, 2} }
+		},
+		{	rsLinkbot::INCHWORM, "Inchworm", 2,
+			{	{rs::LINKBOTL, {0, 0, 0}, {0, 0, 0}},
+				{rs::LINKBOTL, {0.09, 0, 0}, {0, 0, 180}} },
+			1,
+			{	{0, 1, rs::SIMPLE, 1, 1} }
+		},
+		{	rsLinkbot::LIFT, "Lift", 4,
+			{	{rs::LINKBOTI, {0, 0, 0}, {0, 0, 0}},
+				{rs::LINKBOTI, {0, 0.1, 0}, {0, 0, 180}},
+				{rs::LINKBOTL, {0, 0, 0.09}, {0, 0, 0}},
+				{rs::LINKBOTL, {0, 0.1, 0.09}, {0, 0, 180}} },
+			8,
+			{	{0, 1, rs::SMALLWHEEL, -1, 0},
+				{0, 3, rs::SMALLWHEEL, -1, 0},
+				{1, 1, rs::SMALLWHEEL, -1, 0},
+				{1, 3, rs::SMALLWHEEL, -1, 0},
+				{0, 2, rs::SIMPLE, 2, 1},
+				{1, 2, rs::SIMPLE, 3, 1},
+				{2, 2, rs::SIMPLE, 3, 2},
+				{2, 3, rs::SIMPLE, 3, 3} }
+		},
+		{	rsLinkbot::OMNIDRIVE, "Omnidrive", 4,
+			{	{rs::LINKBOTI, {0, -0.09, 0}, {0, 0, 0}},
+				{rs::LINKBOTI, {0.09, 0, 0}, {0, 0, 90}},
+				{rs::LINKBOTI, {0, 0.09, 0}, {0, 0, 180}},
+				{rs::LINKBOTI, {-0.09, 0, 0}, {0, 0, -90}} },
+			8,
+			{	{0, 1, rs::SMALLWHEEL, -1, 0},
+				{1, 1, rs::SMALLWHEEL, -1, 0},
+				{2, 1, rs::SMALLWHEEL, -1, 0},
+				{3, 1, rs::SMALLWHEEL, -1, 0},
+				{0, 3, rs::SIMPLE, 1, 3},
+				{1, 3, rs::SIMPLE, 2, 3},
+				{2, 3, rs::SIMPLE, 3, 3},
+				{3, 3, rs::SIMPLE, 0, 3} }
+		},
+		{	rsLinkbot::SNAKE, "Snake", 5,
+			{	{rs::LINKBOTI, {0, 0, 0}, {0, 0, 0}},
+				{rs::LINKBOTL, {0.09, 0, 0}, {0, 0, 0}},
+				{rs::LINKBOTL, {0.18, 0, 0}, {0, 0, 0}},
+				{rs::LINKBOTL, {0.27, 0, 0}, {0, 0, 0}},
+				{rs::LINKBOTI, {0.36, 0, 0}, {0, 0, 180}} },
+			8,
+			{	{0, 1, rs::SMALLWHEEL, -1, 0},
+				{0, 2, rs::CASTER, -1, 0},
+				{0, 3, rs::SIMPLE, 1, 1},
+				{1, 3, rs::SIMPLE, 2, 1},
+				{2, 3, rs::SIMPLE, 3, 1},
+				{3, 3, rs::SIMPLE, 4, 3},
+				{4, 1, rs::SMALLWHEEL, -1, 0},
+				{4, 2, rs::CASTER, -1, 0} }
+		},
+		{	rsLinkbot::STAND, "Stand", 2,
+			{	{rs::LINKBOTI, {0, 0, 0}, {0, 0, 0}},
+				{rs::LINKBOTL, {0, 0, 0.09}, {90, 0, 0}} },
+			3,
+			{	{0, 1, rs::SMALLWHEEL, -1, 0},
+				{0, 3, rs::SMALLWHEEL, -1, 0},
+				{0, 2, rs::SIMPLE, 1, 1} }
+		},
+	};
+	const int num_templates = sizeof(templates)/sizeof(templates[0]);
+}
+
+/*!
+	Returns the template of a preconfiguration, or NULL if there is none.
+*/
+const PreconfigTemplate* rsModel::preconfigTemplate(int type) {
+	for (int i = 0; i < num_templates; i++) {
+		if (templates[i].type == type)
+			return &templates[i];
+	}
+	return 0;
+}
+
+/*!
+	Fills the half extents of the ground area covered by the members of
+	a preconfiguration, including the body of each member.
+*/
+void rsModel::preconfigExtent(int type, double *hx, double *hy) {
+	*hx = *hy = 0;
+	const PreconfigTemplate *t = rsModel::preconfigTemplate(type);
+	if (!t) return;
+	for (int i = 0; i < t->num_members; i++) {
+		*hx = std::max(*hx, fabs(t->members[i].p[0]));
+		*hy = std::max(*hy, fabs(t->members[i].p[1]));
+	}
+	*hx += 0.0575;
+	*hy += 0.045;
+}
@@ -0,0 +1,158 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include <QAtomicInt>
+#include <QFile>
+#include <QTextStream>
+
+#include "profiler.h"
+
+#if __cplusplus >= 201103L
+#define PROFILER_THROW
+#define PROFILER_NOTHROW noexcept
+#else
+#define PROFILER_THROW throw(std::bad_alloc)
+#define PROFILER_NOTHROW throw()
+#endif
+
+namespace {
+	// plain statics so they are usable before any constructor runs
+	QBasicAtomicInt counting = Q_BASIC_ATOMIC_INITIALIZER(0);
+	QBasicAtomicInt allocations = Q_BASIC_ATOMIC_INITIALIZER(0);
+	QBasicAtomicInt chunks = Q_BASIC_ATOMIC_INITIALIZER(0);		// 16 byte units
+
+	void* allocate(std::size_t size) {
+		profiler::countAllocation(size);
+		void *p = std::malloc(size ? size : 1);
+		if (!p) throw std::bad_alloc();
+		return p;
+	}
+
+	qint64 allocatedBytes(void) {
+		return 16*static_cast<qint64>(static_cast<int>(chunks));
+	}
+}
+
+void* operator new(std::size_t size) PROFILER_THROW { return allocate(size); }
+void* operator new[](std::size_t size) PROFILER_THROW { return allocate(size); }
+void operator delete(void *p) PROFILER_NOTHROW { std::free(p); }
+void operator delete[](void *p) PROFILER_NOTHROW { std::free(p); }
+
+bool profiler::_enabled = false;
+QString profiler::_trace;
+QElapsedTimer profiler::_timer;
+std::vector<profiler::phase> profiler::_phases;
+std::vector<int> profiler::_open;
+
+/*!
+	Enables profiling from --profile[=file] arguments or the
+	ROBOSIM_PROFILE environment variable.
+*/
+void profiler::configure(int argc, char **argv) {
+	const char *env = getenv("ROBOSIM_PROFILE");
+	if (env && *env && strcmp(env, "0"))
+		profiler::enable(strcmp(env, "1") ? QString::fromLocal8Bit(env) : QString());
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--profile"))
+			profiler::enable();
+		else if (!strncmp(argv[i], "--profile=", 10))
+			profiler::enable(QString::fromLocal8Bit(argv[i] + 10));
+	}
+}
+
+/*!
+	Starts timing and allocation counting. A trace file in the Chrome
+	trace event format is written by report() when a name is given.
+*/
+void profiler::enable(const QString &trace) {
+	if (!trace.isEmpty()) _trace = trace;
+	if (_enabled) return;
+	_enabled = true;
+	_timer.start();
+	counting.fetchAndStoreOrdered(1);
+}
+
+bool profiler::isEnabled(void) {
+	return _enabled;
+}
+
+void profiler::begin(const char *name) {
+	if (!_enabled) return;
+
+	phase p;
+	p.name = name;
+	p.depth = _open.size();
+	p.start = p.stop = _timer.nsecsElapsed();
+	p.allocs_start = p.allocs_stop = allocations;
+	p.bytes_start = p.bytes_stop = allocatedBytes();
+	_open.push_back(_phases.size());
+	_phases.push_back(p);
+}
+
+void profiler::end(void) {
+	if (!_enabled || _open.empty()) return;
+
+	phase &p = _phases[_open.back()];
+	_open.pop_back();
+	p.stop = _timer.nsecsElapsed();
+	p.allocs_stop = allocations;
+	p.bytes_stop = allocatedBytes();
+}
+
+/*!
+	Prints the wall time, allocation count and allocated bytes of every
+	phase, indented by nesting, and writes the trace file if one was
+	asked for. The counts cover operator new only.
+*/
+void profiler::report(void) {
+	if (!_enabled) return;
+	while (!_open.empty())
+		profiler::end();
+
+	std::cerr << "phase                                  wall ms  new calls    new bytes" << std::endl;
+	for (unsigned int i = 0; i < _phases.size(); i++) {
+		const phase &p = _phases[i];
+		QString name = QString(2*p.depth, ' ') + p.name;
+		std::cerr << qPrintable(name.leftJustified(36))
+				  << qPrintable(QString::number((p.stop - p.start)/1.0e6, 'f', 2).rightJustified(11))
+				  << qPrintable(QString::number(p.allocs_stop - p.allocs_start).rightJustified(11))
+				  << qPrintable(QString::number(p.bytes_stop - p.bytes_start).rightJustified(13))
+				  << std::endl;
+	}
+
+	if (!_trace.isEmpty() && !profiler::write_trace())
+		std::cerr << "Error: Cannot write trace file " << qPrintable(_trace) << std::endl;
+}
+
+void profiler::countAllocation(std::size_t size) {
+	if (!counting) return;
+	allocations.fetchAndAddRelaxed(1);
+	chunks.fetchAndAddRelaxed(static_cast<int>((size + 15) >> 4));
+}
+
+/*!
+	Writes phases as complete events of the Chrome trace event format,
+	which chrome://tracing and Perfetto open.
+*/
+bool profiler::write_trace(void) {
+	QFile file(_trace);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+		return false;
+
+	QTextStream out(&file);
+	out << "{\"traceEvents\": [\n";
+	for (unsigned int i = 0; i < _phases.size(); i++) {
+		const phase &p = _phases[i];
+		out << "  {\"name\": \"" << p.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1"
+			<< ", \"ts\": " << QString::number(p.start/1.0e3, 'f', 3)
+			<< ", \"dur\": " << QString::number((p.stop - p.start)/1.0e3, 'f', 3)
+			<< ", \"args\": {\"new_calls\": " << (p.allocs_stop - p.allocs_start)
+			<< ", \"new_bytes\": " << (p.bytes_stop - p.bytes_start) << "}}"
+			<< ((i + 1 < _phases.size()) ? ",\n" : "\n");
+	}
+	out << "]}\n";
+	return file.error() == QFile::NoError;
+}
@@ -1,3 +1,4 @@
+#include "profiler.h"
 #include "qosgwidget.h"
 
 #include <osgGA/TrackballManipulator>
@@ -6,6 +7,7 @@
 
 QOsgWidget::QOsgWidget(QWidget *parent) : osgQt::GLWidget(parent) {
 	// create new scene
+	profiler::begin("osg scene");
 	_scene = new rsScene::Scene();
 
 	// privide reference count
@@ -21,6 +23,7 @@ QOsgWidget::QOsgWidget(QWidget *parent) : osgQt::GLWidget(parent) {
 	grid.push_back(48/39.37);
 	grid.push_back(1);
 	_scene->setGrid(0, grid);
+	profiler::end();
 
 	// set display settings
 	osg::DisplaySettings *ds = osg::DisplaySettings::instance().get();
@@ -34,82 +37,110 @@ QOsgWidget::QOsgWidget(QWidget *parent) : osgQt::GLWidget(parent) {
 	osg::ref_ptr<osgQt::GraphicsWindowQt> gw = new osgQt::GraphicsWindowQt(traits.get());
 
 	// create viewer
+	profiler::begin("osg viewer and camera");
 	_scene->setupViewer(dynamic_cast<osgViewer::Viewer*>(this));
 	_scene->setupCamera(gw, traits->width, traits->height);
 	_scene->setupScene(traits->width, traits->height);
+	profiler::end();
 
 	// set highlighting of click
 	_scene->setHighlight(true);
 	_scene->setLabel(false);
 
-	// draw viewer
-	osgQt::setViewer(this);
-
-	double pos[3] = {0.2, 0.2, 0};
-	double color[4] = {0, 0, 1, 1};
-	double dims[3] = {0.1, 0.1, 0.1};
-	double quat[4] = {0, 0, 0, 1};
-	_scene->drawGround(rs::BOX, pos, color, dims, quat);
-	_scene->addChild();
+	// draw viewer only when something changed
+	_dirty = true;
+	_on_demand = true;
+	this->setRunFrameScheme(osgViewer::ViewerBase::ON_DEMAND);
+	this->setMaxFrameRate(60);
+	QObject::connect(&_timer, SIGNAL(timeout()), this, SLOT(render()));
+	_timer.start();
+
+	// attach obstacles kept in sync with their model, merged by material
+	_obstacles = new obstacleSync(this);
+	this->getSceneData()->asGroup()->addChild(_obstacles->getRoot());
+	QObject::connect(_obstacles, SIGNAL(sceneChanged()), this, SLOT(requestRedraw()));
+
+	// attach robots kept in sync with the model
+	_sync = new sceneSync(this);
+	this->getSceneData()->asGroup()->addChild(_sync->getRoot());
+	QObject::connect(_sync, SIGNAL(sceneChanged()), this, SLOT(requestRedraw()));
+	QObject::connect(_sync, SIGNAL(robotPicked(const QModelIndex&)), this, SIGNAL(indexChanged(const QModelIndex&)));
+
+	// drag robots in the view; the camera ignores events the dragger used
+	_dragger = new robotDragger(_sync);
+	this->addEventHandler(_dragger.get());
+	if (this->getCameraManipulator())
+		this->getCameraManipulator()->setIgnoreHandledEventsMask(osgGA::GUIEventAdapter::PUSH | osgGA::GUIEventAdapter::DRAG | osgGA::GUIEventAdapter::RELEASE);
 }
 
 QOsgWidget::~QOsgWidget(void) {
     this->unref();
 }
 
+/*!
+	Caps the rate at which frames are drawn.
+*/
+void QOsgWidget::setMaxFrameRate(double fps) {
+	_timer.setInterval((fps > 0) ? static_cast<int>(1000/fps) : 0);
+}
+
 void QOsgWidget::setModel(robotModel *model) {
-	// set model
-	_model = model;
+	// keep scene in sync with model
+	_sync->setModel(model);
+	_dragger->setModel(model);
+}
 
-	// update view with default model
-	this->dataChanged(_model->index(0, 0), _model->index(_model->rowCount()-1, 0));
+void QOsgWidget::setObstacleModel(obstacleModel *model) {
+	_obstacles->setModel(model);
 }
 
-void QOsgWidget::dataChanged(QModelIndex topLeft, QModelIndex bottomRight) {
-	// draw all new robots
-	for (int i = topLeft.row(); i <= bottomRight.row(); i++) {
-		int form = _model->data(_model->index(i, rsModel::FORM)).toInt();
-		double pos[3] = {_model->data(_model->index(i, rsModel::P_X)).toDouble(),
-						 _model->data(_model->index(i, rsModel::P_Y)).toDouble(),
-						 _model->data(_model->index(i, rsModel::P_Z)).toDouble() + 0.04445};
-		double quat[4] = {0, 0, 0, 1};
-
-		switch (form) {
-			case rs::LINKBOTI: {
-				rsRobots::LinkbotI *robot = new rsRobots::LinkbotI();
-				rsScene::Robot *sceneRobot = _scene->drawRobot(robot, form, pos, quat, 1);
-				_scene->drawConnector(robot, sceneRobot, rs::SIMPLE, rsRobots::LinkbotI::FACE1, 0, 1, -1);
-				_scene->drawConnector(robot, sceneRobot, rs::SIMPLE, rsRobots::LinkbotI::FACE1, 0, 2, rs::SMALLWHEEL);
-				_scene->drawConnector(robot, sceneRobot, rs::SIMPLE, rsRobots::LinkbotI::FACE2, 0, 1, -1);
-				_scene->drawConnector(robot, sceneRobot, rs::SIMPLE, rsRobots::LinkbotI::FACE2, 0, 2, rs::CASTER);
-				_scene->drawConnector(robot, sceneRobot, rs::SIMPLE, rsRobots::LinkbotI::FACE3, 0, 1, -1);
-				_scene->drawConnector(robot, sceneRobot, rs::SIMPLE, rsRobots::LinkbotI::FACE3, 0, 2, rs::SMALLWHEEL);
-				break;
-			}
-			case rs::LINKBOTL:
-				_scene->drawRobot(new rsRobots::LinkbotL(), form, pos, quat, 1);
-				break;
-			case rs::LINKBOTT:
-				_scene->drawRobot(new rsRobots::LinkbotT(), form, pos, quat, 1);
-				break;
-			default:
-				break;
-		}
-		_robots.push_back(_scene->addChild());
-	}
+void QOsgWidget::setCurrentIndex(const QModelIndex &index) {
+	_sync->setCurrentIndex(index);
+}
 
-	// set current robot
-	_current = bottomRight.row();
-	_scene->addHighlight(_robots.back());
+/*!
+	Switches between drawing frames only when the scene, camera or window
+	changed and drawing frames continuously at the maximum frame rate.
+*/
+void QOsgWidget::setRenderOnDemand(bool on) {
+	_on_demand = on;
+	this->requestRedraw();
 }
 
-void QOsgWidget::setCurrentIndex(const QModelIndex &index) {
-	// do nothing when indices are the same
-	if (_current == index.row()) return;
+/*!
+	Marks the view as out of date so the next timer tick draws a frame.
+*/
+void QOsgWidget::requestRedraw(void) {
+	_dirty = true;
+	if (!_timer.isActive()) _timer.start();
+}
 
-	// set new current robot
-	_current = index.row();
+bool QOsgWidget::event(QEvent *event) {
+	// let the graphics window queue the event for the viewer
+	bool handled = osgQt::GLWidget::event(event);
+
+	// window and input events may change the view
+	switch (event->type()) {
+		case QEvent::KeyPress: case QEvent::KeyRelease:
+		case QEvent::MouseButtonPress: case QEvent::MouseButtonRelease:
+		case QEvent::MouseButtonDblClick: case QEvent::MouseMove:
+		case QEvent::Wheel: case QEvent::Resize: case QEvent::Paint:
+		case QEvent::Show: case QEvent::WindowActivate:
+			this->requestRedraw();
+			break;
+		default:
+			break;
+	}
+	return handled;
+}
 
-	// update view
-	_scene->addHighlight(_robots[_current]);
+void QOsgWidget::render(void) {
+	// draw when asked to or when the camera manipulator is animating
+	if (!_on_demand || _dirty || _requestRedraw || _requestContinousUpdate) {
+		_dirty = false;
+		_requestRedraw = false;
+		this->frame();
+	}
+	else
+		_timer.stop();
 }
@@ -0,0 +1,111 @@
+#include <cmath>
+
+#include <osgViewer/View>
+
+#include "robotdragger.h"
+
+/*!
+	Moves robots by dragging them across the ground with the left mouse
+	button, or rotates them about their vertical axis when shift is held.
+	While dragging only the robot's transform node moves; the final pose
+	is written to the model once, when the button is released.
+*/
+robotDragger::robotDragger(sceneSync *sync) {
+	_model = NULL;
+	_sync = sync;
+	_row = -1;
+	_rotate = false;
+	_moved = false;
+}
+
+void robotDragger::setModel(robotModel *model) {
+	_model = model;
+	_row = -1;
+}
+
+bool robotDragger::handle(const osgGA::GUIEventAdapter &ea, osgGA::GUIActionAdapter &aa) {
+	if (!_model) return false;
+
+	switch (ea.getEventType()) {
+		case osgGA::GUIEventAdapter::PUSH: {
+			if (ea.getButton() != osgGA::GUIEventAdapter::LEFT_MOUSE_BUTTON) return false;
+
+			// pick robot under the cursor on the ground plane
+			double x, y;
+			if (!this->ground_point(ea, aa, &x, &y)) return false;
+			_row = _model->getIndex()->at(x, y);
+			if (_row < 0) return false;
+
+			_start[0] = x;
+			_start[1] = y;
+			_model->getPosition(_row, _p);
+			_model->getRotation(_row, _r);
+			_x = _p[0];
+			_y = _p[1];
+			_psi = _r[2];
+			_rotate = (ea.getModKeyMask() & osgGA::GUIEventAdapter::MODKEY_SHIFT) != 0;
+			_moved = false;
+			_sync->pickRobot(_row);
+			return true;
+		}
+		case osgGA::GUIEventAdapter::DRAG: {
+			if (_row < 0) return false;
+
+			double x, y;
+			if (!this->ground_point(ea, aa, &x, &y)) return true;
+			if (_rotate) {
+				double a0 = atan2(_start[1] - _p[1], _start[0] - _p[0]);
+				double a1 = atan2(y - _p[1], x - _p[0]);
+				_psi = _r[2] + (a1 - a0)*57.29577951308232;
+			}
+			else {
+				_x = _p[0] + x - _start[0];
+				_y = _p[1] + y - _start[1];
+			}
+			_moved = true;
+
+			// move the scene node only
+			_sync->previewPose(_row, _x, _y, _psi);
+			aa.requestRedraw();
+			return true;
+		}
+		case osgGA::GUIEventAdapter::RELEASE: {
+			if (_row < 0) return false;
+
+			// write final pose back as one model update
+			if (_moved) {
+				robotModelUpdate update(_model);
+				_model->setDouble(_row, rsModel::P_X, _x);
+				_model->setDouble(_row, rsModel::P_Y, _y);
+				_model->setDouble(_row, rsModel::R_PSI, _psi);
+			}
+			_row = -1;
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+/*!
+	Intersects the ray under the cursor with the ground plane z = 0.
+*/
+bool robotDragger::ground_point(const osgGA::GUIEventAdapter &ea, osgGA::GUIActionAdapter &aa, double *x, double *y) const {
+	osgViewer::View *view = dynamic_cast<osgViewer::View*>(&aa);
+	if (!view) return false;
+
+	osg::Camera *camera = view->getCamera();
+	osg::Matrixd inverse;
+	if (!inverse.invert(camera->getViewMatrix() * camera->getProjectionMatrix()))
+		return false;
+	osg::Vec3d p0 = osg::Vec3d(ea.getXnormalized(), ea.getYnormalized(), -1) * inverse;
+	osg::Vec3d p1 = osg::Vec3d(ea.getXnormalized(), ea.getYnormalized(), 1) * inverse;
+
+	double dz = p1.z() - p0.z();
+	if (fabs(dz) < 1e-12) return false;
+	double t = -p0.z()/dz;
+	if (t < 0) return false;
+	*x = p0.x() + t*(p1.x() - p0.x());
+	*y = p0.y() + t*(p1.y() - p0.y());
+	return true;
+}
@@ -2,19 +2,18 @@
 
 using namespace rsModel;
 
+namespace {
+	const double DEG2RAD = 0.017453292519943295;
+}
+
 robotModel::robotModel(QObject *parent) : QAbstractTableModel(parent) {
-	// set up preconfig
-	_l_preconfig[rsLinkbot::BOW] = 2;
-	_l_preconfig[rsLinkbot::EXPLORER] = 5;
-	_l_preconfig[rsLinkbot::FOURBOTDRIVE] = 4;
-	_l_preconfig[rsLinkbot::FOURWHEELDRIVE] = 4;
-	_l_preconfig[rsLinkbot::FOURWHEELEXPLORER] = 5;
-	_l_preconfig[rsLinkbot::GROUPBOW] = 4;
-	_l_preconfig[rsLinkbot::INCHWORM] = 2;
-	_l_preconfig[rsLinkbot::LIFT] = 4;
-	_l_preconfig[rsLinkbot::OMNIDRIVE] = 4;
-	_l_preconfig[rsLinkbot::SNAKE] = 5;
-	_l_preconfig[rsLinkbot::STAND] = 2;
+	_update_depth = 0;
+
+	// set up preconfig sizes from their templates
+	for (int i = 0; i < rsLinkbot::NUM_PRECONFIG; i++) {
+		const PreconfigTemplate *t = rsModel::preconfigTemplate(i);
+		_l_preconfig[i] = (t) ? t->num_members : 1;
+	}
 
 	// create initial robot for model
 	this->addRobot();
@@ -24,49 +23,163 @@ robotModel::~robotModel(void) {
 }
 
 bool robotModel::addRobot(int role) {
-	int row = _list.size();
-	this->insertRows(row, 1);
-
-	if (role == Qt::EditRole) {
-		_list[row][ID] = QVariant((row) ? this->data(createIndex(row-1, ID), Qt::EditRole).toInt() + 1 : 0).toString();
-		_list[row][FORM] = QVariant(rs::LINKBOTI).toString();
-		_list[row][P_X] = QVariant((row) ? this->data(createIndex(row-1, P_X)).toDouble() + 0.1524 : 0).toString();	// offset by 6 inches
-		emit dataChanged(createIndex(row, 0), createIndex(row, NUM_COLUMNS));
-		return true;
-	}
-	return false;
+	if (role != Qt::EditRole) return false;
+
+	rsModel::RobotSpec spec;
+	this->place_robot(spec);
+	return this->addRobots(&spec, 1);
 }
 
 bool robotModel::addPreconfig(int type, int role) {
-	int row = _list.size();
-	this->insertRows(row, 1);
+	if (role != Qt::EditRole) return false;
+	if (!rsModel::preconfigTemplate(type)) return false;
 
-	if (role == Qt::EditRole) {
-		if (row && this->data(createIndex(row-1, PRECONFIG), Qt::EditRole).toInt()) {
-			_list[row][ID] = QVariant(this->data(createIndex(row-1, ID), Qt::EditRole).toInt() + 1 + _l_preconfig[type]).toString();
-		}
-		else {
-			_list[row][ID] = QVariant((row) ? this->data(createIndex(row-1, ID), Qt::EditRole).toInt() + 1 : 0).toString();
+	rsModel::RobotSpec spec;
+	spec.preconfig = type;
+	this->place_robot(spec);
+	return this->addRobots(&spec, 1);
+}
+
+/*!
+	Appends count robots to the model. Rows are inserted with a single
+	beginInsertRows()/endInsertRows() pair and announced with a single
+	dataChanged() spanning the whole block, so attached views rebuild
+	once per batch instead of once per robot.
+*/
+bool robotModel::addRobots(const rsModel::RobotSpec *spec, int count) {
+	return this->insertRobots(_id.size(), spec, count);
+}
+
+bool robotModel::addRobots(const std::vector<rsModel::RobotSpec> &specs) {
+	if (specs.empty()) return false;
+	return this->addRobots(&specs[0], specs.size());
+}
+
+/*!
+	Inserts count robots before the given row, as addRobots() does at the
+	end of the model.
+*/
+bool robotModel::insertRobots(int row, const rsModel::RobotSpec *spec, int count) {
+	if (count <= 0 || row < 0 || row > static_cast<int>(_id.size())) return false;
+
+	beginInsertRows(QModelIndex(), row, row + count - 1);
+	this->insert_rows(row, count);
+	this->shift_pending(row, count);
+
+	for (int i = 0; i < count; i++) {
+		int r = row + i;
+		_preconfig[r] = spec[i].preconfig;
+		int block = this->id_block(_preconfig[r]);
+		_id[r] = (spec[i].id >= 0 && _ids.reserve(spec[i].id, block)) ? spec[i].id : _ids.allocate(block);
+		this->map_id(r);
+		_form[r] = spec[i].form;
+		_wheel[r] = spec[i].wheel;
+		for (int j = 0; j < 3; j++) {
+			_p[j][r] = spec[i].p[j];
+			_r[j][r] = spec[i].r[j];
 		}
-		_list[row][FORM] = QVariant(rs::LINKBOTI).toString();
-		_list[row][P_X] = QVariant((row) ? this->data(createIndex(row-1, P_X)).toDouble() + 0.1524 : 0).toString();	// offset by 6 inches
-		_list[row][PRECONFIG] = QVariant(type).toString();
-		emit dataChanged(createIndex(row, 0), createIndex(row, NUM_COLUMNS));
-		return true;
+		_radius[r] = spec[i].radius;
+		this->update_index(r);
 	}
-	return false;
+	this->map_ids(row + count, _id.size());
+	endInsertRows();
+	this->changed(row, row + count - 1, 0, NUM_COLUMNS-1);
+
+	// success
+	return true;
 }
 
 void robotModel::printModel(void) {
 	std::cerr << "data: " << std::endl;
-	for (int i = 0; i < _list.size(); i++) {
+	for (unsigned int i = 0; i < _id.size(); i++) {
 		for (int j = 0; j < NUM_COLUMNS; j++) {
-			std::cerr << (_list[i][j]).toStdString() << " ";
+			if (rsModel::isIntColumn(j))
+				std::cerr << this->getInt(i, j) << " ";
+			else
+				std::cerr << this->getDouble(i, j) << " ";
 		}
 		std::cerr << std::endl;
 	}
 }
 
+/*!
+	Returns the integer value stored at the given row and column.
+	Double columns are truncated.
+*/
+int robotModel::getInt(int row, int column) const {
+	const std::vector<int> *list = this->int_column(column);
+	if (list) return (*list)[row];
+	return static_cast<int>((*this->double_column(column))[row]);
+}
+
+/*!
+	Returns the double value stored at the given row and column.
+*/
+double robotModel::getDouble(int row, int column) const {
+	const std::vector<double> *list = this->double_column(column);
+	if (list) return (*list)[row];
+	return (*this->int_column(column))[row];
+}
+
+/*!
+	Fills p[3] with the position of the robot at the given row.
+*/
+void robotModel::getPosition(int row, double *p) const {
+	p[0] = _p[0][row];
+	p[1] = _p[1][row];
+	p[2] = _p[2][row];
+}
+
+/*!
+	Fills r[3] with the phi, theta, psi rotation of the robot at the given row.
+*/
+void robotModel::getRotation(int row, double *r) const {
+	r[0] = _r[0][row];
+	r[1] = _r[1][row];
+	r[2] = _r[2][row];
+}
+
+/*!
+	Sets an integer value directly and emits dataChanged() for the cell,
+	or records it until the current update ends.
+*/
+bool robotModel::setInt(int row, int column, int value) {
+	if (row < 0 || row >= this->rowCount()) return false;
+
+	// ids must stay unique
+	if (column == ID || column == PRECONFIG) {
+		if (!this->set_id(row, (column == ID) ? value : _id[row], (column == PRECONFIG) ? value : _preconfig[row]))
+			return false;
+		this->update_index(row);
+		_labels[row].clear();
+		this->changed(row, row, ID, PRECONFIG);
+		return true;
+	}
+
+	std::vector<int> *list = this->int_column(column);
+	if (list) (*list)[row] = value;
+	else (*this->double_column(column))[row] = value;
+	if (column == FORM) _labels[row].clear();
+	this->update_index(row);
+	this->changed(row, row, column, column);
+	return true;
+}
+
+/*!
+	Sets a double value directly and emits dataChanged() for the cell,
+	or records it until the current update ends.
+*/
+bool robotModel::setDouble(int row, int column, double value) {
+	if (row < 0 || row >= this->rowCount()) return false;
+	if (rsModel::isIntColumn(column))
+		return this->setInt(row, column, static_cast<int>(value));
+
+	(*this->double_column(column))[row] = value;
+	this->update_index(row);
+	this->changed(row, row, column, column);
+	return true;
+}
+
 /*!
 	Returns the number of items in the row list as the number of rows
 	in the model.
@@ -80,7 +193,7 @@ int robotModel::columnCount(const QModelIndex&) const {
 	in the model.
 */
 int robotModel::rowCount(const QModelIndex&) const {
-	return _list.size();
+	return _id.size();
 }
 
 /*!
@@ -99,82 +212,188 @@ QVariant robotModel::data(const QModelIndex &index, int role) const {
 
 	// return data
 	if (role == Qt::DisplayRole) {
-		if (index.column() == rsModel::ID) {
-			switch (_list[index.row()][rsModel::FORM].toInt()) {
-				case rs::LINKBOTI: case rs::LINKBOTL: case rs::LINKBOTT: {
-					int id = _list[index.row()][rsModel::ID].toInt();
-					switch (_list[index.row()][rsModel::PRECONFIG].toInt()) {
-						case rsLinkbot::BOW:				return QString("Bow\nRobots %1 - %2").arg(id + 1).arg(id + _l_preconfig[rsLinkbot::BOW] + 1); break;
-						case rsLinkbot::EXPLORER:			return QString("Explorer\nRobots %1 - %2").arg(id + 1).arg(id + _l_preconfig[rsLinkbot::EXPLORER] + 1); break;
-						case rsLinkbot::FOURBOTDRIVE:		return QString("Four Bot Drive\nRobots %1 - %2").arg(id + 1).arg(id + _l_preconfig[rsLinkbot::FOURBOTDRIVE] + 1); break;
-						case rsLinkbot::FOURWHEELDRIVE:		return QString("Four Wheel Drive\nRobots %1 - %2").arg(id + 1).arg(id + _l_preconfig[rsLinkbot::FOURWHEELDRIVE] + 1); break;
-						case rsLinkbot::FOURWHEELEXPLORER:	return QString("Four Wheel Explorer\nRobots %1 - %2").arg(id + 1).arg(id + _l_preconfig[rsLinkbot::FOURWHEELEXPLORER] + 1); break;
-						case rsLinkbot::GROUPBOW:			return QString("Group Bow\nRobots %1 - %2").arg(id + 1).arg(id + _l_preconfig[rsLinkbot::GROUPBOW] + 1); break;
-						case rsLinkbot::INCHWORM:			return QString("Inchworm\nRobots %1 - %2").arg(id + 1).arg(id + _l_preconfig[rsLinkbot::INCHWORM] + 1); break;
-						case rsLinkbot::LIFT:				return QString("Lift\nRobots %1 - %2").arg(id + 1).arg(id + _l_preconfig[rsLinkbot::LIFT] + 1); break;
-						case rsLinkbot::OMNIDRIVE:			return QString("Omnidrive\nRobots %1 - %2").arg(id + 1).arg(id + _l_preconfig[rsLinkbot::OMNIDRIVE] + 1); break;
-						case rsLinkbot::SNAKE:				return QString("Snake\nRobots %1 - %2").arg(id + 1).arg(id + _l_preconfig[rsLinkbot::SNAKE] + 1); break;
-						case rsLinkbot::STAND:				return QString("StandRobots %1 - %2").arg(id + 1).arg(id + _l_preconfig[rsLinkbot::STAND] + 1); break;
-						default:							return QString("Robot %1").arg(id + 1); break;
-					}
-				}
-				case rs::MOBOT:
-					return QString("Robot %1").arg(_list[index.row()][index.column()].toInt() + 1);
-					break;
-				case rs::NXT:
-					return QString("Robot %1").arg(_list[index.row()][index.column()].toInt() + 1);
-					break;
-				default:
-					return QString("Robot %1").arg(_list[index.row()][index.column()].toInt() + 1);
-					break;
-			}
-		}
+		if (index.column() == rsModel::ID)
+			return this->label(index.row());
+		else if (rsModel::isIntColumn(index.column()))
+			return this->getInt(index.row(), index.column());
 		else
-			return _list[index.row()][index.column()];
+			return this->getDouble(index.row(), index.column());
 	}
-	else if (role == Qt::EditRole)
-		return _list[index.row()][index.column()];
-	else if (role == Qt::DecorationRole) {
-		QPixmap image;
-		switch (_list[index.row()][rsModel::FORM].toInt()) {
-			case rs::LINKBOTI: {
-				switch (_list[index.row()][rsModel::PRECONFIG].toInt()) {
-					case rsLinkbot::BOW:				image.load("monkey_off_32x32.png"); break;
-					case rsLinkbot::EXPLORER:			image.load("monkey_on_32x32.png"); break;
-					case rsLinkbot::FOURBOTDRIVE:		image.load("monkey_on_32x32.png"); break;
-					case rsLinkbot::FOURWHEELDRIVE:		image.load("monkey_on_32x32.png"); break;
-					case rsLinkbot::FOURWHEELEXPLORER:	image.load("monkey_on_32x32.png"); break;
-					case rsLinkbot::GROUPBOW:			image.load("monkey_on_32x32.png"); break;
-					case rsLinkbot::INCHWORM:			image.load("monkey_on_32x32.png"); break;
-					case rsLinkbot::LIFT:				image.load("monkey_on_32x32.png"); break;
-					case rsLinkbot::OMNIDRIVE:			image.load("monkey_on_32x32.png"); break;
-					case rsLinkbot::SNAKE:				image.load("monkey_on_32x32.png"); break;
-					case rsLinkbot::STAND:				image.load("monkey_on_32x32.png"); break;
-					default: 							image.load("linkbotI.png"); break;
-				}
-			}
-			case rs::LINKBOTL:
-				image.load("linkbotI.jpg");
-				break;
-			case rs::LINKBOTT:
-				image.load("linkbotL.jpg");
-				break;
-			case rs::MOBOT:
-				image.load("mobot.jpg");
-				break;
-			case rs::NXT:
-				image.load("mobot.jpg");
-				break;
-			default:
-				image.load("monkey_on_32x32.png");
-				break;
-		}
-		return image;
+	else if (role == Qt::EditRole) {
+		if (rsModel::isIntColumn(index.column()))
+			return this->getInt(index.row(), index.column());
+		return this->getDouble(index.row(), index.column());
 	}
+	else if (role == Qt::DecorationRole)
+		return this->icon(_form[index.row()], _preconfig[index.row()]);
 	else
 		return QVariant();
 }
 
+/*!
+	Returns the display label of a robot. Labels are built once per row
+	and cached until the robot's id, form or preconfig changes, so views
+	repainting many rows do no string formatting.
+*/
+const QString& robotModel::label(int row) const {
+	QString &text = _labels[row];
+	if (!text.isEmpty()) return text;
+
+	int id = _id[row];
+	const PreconfigTemplate *t = NULL;
+	switch (_form[row]) {
+		case rs::LINKBOTI: case rs::LINKBOTL: case rs::LINKBOTT:
+			t = rsModel::preconfigTemplate(_preconfig[row]);
+			break;
+		default:
+			break;
+	}
+	if (t)
+		text = QString("%1\nRobots %2 - %3").arg(t->name).arg(id + 1).arg(id + t->num_members);
+	else
+		text = QString("Robot %1").arg(id + 1);
+	return text;
+}
+
+/*!
+	Fills the half extents of the ground footprint of a robot: hx along
+	the wheel axis and hy along the direction of travel, in meters.
+*/
+void robotModel::getFootprint(const rsModel::RobotSpec &spec, double *hx, double *hy) {
+	// body
+	switch (spec.form) {
+		case rs::LINKBOTL: case rs::LINKBOTT:
+			*hx = 0.0635;
+			*hy = 0.045;
+			break;
+		case rs::MOBOT:
+			*hx = 0.13;
+			*hy = 0.05;
+			break;
+		default:
+			*hx = 0.045;
+			*hy = 0.045;
+			break;
+	}
+
+	// wheels on the outer faces
+	double radius = 0;
+	switch (spec.wheel) {
+		case 1: radius = 1.625*0.0254; break;
+		case 2: radius = 1.75*0.0254; break;
+		case 3: radius = 2.00*0.0254; break;
+		case 4: radius = spec.radius; break;
+		default: break;
+	}
+	if (spec.form == rs::LINKBOTI || radius > 0) {
+		*hx += 0.0125;
+		*hy = qMax(*hy, radius);
+	}
+
+	// preconfigured robots cover the spread of their members
+	if (spec.preconfig > 0 && spec.preconfig < rsLinkbot::NUM_PRECONFIG) {
+		rsModel::preconfigExtent(spec.preconfig, hx, hy);
+		*hy = qMax(*hy, radius);
+	}
+}
+
+/*!
+	Returns the spatial index over robot footprints, kept up to date with
+	every change to the model.
+*/
+const spatialIndex* robotModel::getIndex(void) const {
+	return &_index;
+}
+
+/*!
+	Sets the position of a new robot to the free slot nearest to six
+	inches past the last robot.
+*/
+void robotModel::place_robot(rsModel::RobotSpec &spec) const {
+	int row = _id.size();
+	double x = (row) ? _p[0][row-1] + 0.1524 : 0;	// offset by 6 inches
+	double y = (row) ? _p[1][row-1] : 0;
+	double hx, hy;
+	this->getFootprint(spec, &hx, &hy);
+	if (!_index.nearestFree(x, y, hx, hy, 0, &spec.p[0], &spec.p[1])) {
+		spec.p[0] = x;
+		spec.p[1] = y;
+	}
+}
+
+/*!
+	Updates the footprint of a row in the spatial index.
+*/
+void robotModel::update_index(int row) {
+	rsModel::RobotSpec spec;
+	spec.form = _form[row];
+	spec.wheel = _wheel[row];
+	spec.radius = _radius[row];
+	spec.preconfig = _preconfig[row];
+	double hx, hy;
+	this->getFootprint(spec, &hx, &hy);
+	_index.update(row, _p[0][row], _p[1][row], hx, hy, _r[2][row]*DEG2RAD);
+}
+
+/*!
+	Sets the size that decoration pixmaps are scaled to and drops any
+	pixmaps cached at the previous size.
+*/
+void robotModel::setIconSize(const QSize &size) {
+	if (size == _icon_size) return;
+	_icon_size = size;
+	_icons.clear();
+}
+
+/*!
+	Returns the decoration for a (form, preconfig) pair. Each image is
+	loaded from disk and scaled once, on first use, and then shared by
+	every row with the same pair.
+*/
+QPixmap robotModel::icon(int form, int preconfig) const {
+	QPair<int, int> key(form, preconfig);
+	QHash<QPair<int, int>, QPixmap>::const_iterator i = _icons.constFind(key);
+	if (i != _icons.constEnd())
+		return i.value();
+
+	QPixmap image(robotModel::icon_file(form, preconfig));
+	if (!image.isNull() && _icon_size.isValid())
+		image = image.scaled(_icon_size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+	_icons.insert(key, image);
+	return image;
+}
+
+QString robotModel::icon_file(int form, int preconfig) {
+	switch (form) {
+		case rs::LINKBOTI: {
+			switch (preconfig) {
+				case rsLinkbot::BOW:				return "monkey_off_32x32.png";
+				case rsLinkbot::EXPLORER:			return "monkey_on_32x32.png";
+				case rsLinkbot::FOURBOTDRIVE:		return "monkey_on_32x32.png";
+				case rsLinkbot::FOURWHEELDRIVE:		return "monkey_on_32x32.png";
+				case rsLinkbot::FOURWHEELEXPLORER:	return "monkey_on_32x32.png";
+				case rsLinkbot::GROUPBOW:			return "monkey_on_32x32.png";
+				case rsLinkbot::INCHWORM:			return "monkey_on_32x32.png";
+				case rsLinkbot::LIFT:				return "monkey_on_32x32.png";
+				case rsLinkbot::OMNIDRIVE:			return "monkey_on_32x32.png";
+				case rsLinkbot::SNAKE:				return "monkey_on_32x32.png";
+				case rsLinkbot::STAND:				return "monkey_on_32x32.png";
+				default: 							return "linkbotI.jpg";
+			}
+		}
+		case rs::LINKBOTL:
+			return "linkbotI.jpg";
+		case rs::LINKBOTT:
+			return "linkbotL.jpg";
+		case rs::MOBOT:
+			return "mobot.jpg";
+		case rs::NXT:
+			return "mobot.jpg";
+		default:
+			return "monkey_on_32x32.png";
+	}
+}
+
 /*!
 	Returns the appropriate header string depending on the orientation of
 	the header and the section. If anything other than the display role is
@@ -217,13 +436,48 @@ Qt::DropActions robotModel::supportedDropActions(void) const {
 */
 bool robotModel::setData(const QModelIndex &index, const QVariant &value, int role) {
 	if (index.isValid() && role == Qt::EditRole) {
-		_list[index.row()][index.column()] = value.toString();
-		emit dataChanged(index, index);
-		return true;
+		if (rsModel::isIntColumn(index.column()))
+			return this->setInt(index.row(), index.column(), value.toInt());
+		return this->setDouble(index.row(), index.column(), value.toDouble());
 	}
 	return false;
 }
 
+/*!
+	Starts holding back dataChanged() notifications. Updates nest; the
+	changes are announced when the outermost update ends.
+*/
+void robotModel::beginUpdate(void) {
+	_update_depth++;
+}
+
+/*!
+	Ends an update. When the outermost update ends, changed cells are
+	announced with one dataChanged() per run of consecutive rows, each
+	spanning the union of the columns changed in that run.
+*/
+void robotModel::endUpdate(void) {
+	if (_update_depth == 0 || --_update_depth > 0) return;
+
+	std::map<int, QPair<int, int> > pending;
+	pending.swap(_pending);
+	std::map<int, QPair<int, int> >::const_iterator i = pending.begin();
+	while (i != pending.end()) {
+		int first = i->first, last = i->first;
+		int left = i->second.first, right = i->second.second;
+		for (++i; i != pending.end() && i->first == last + 1; ++i) {
+			last = i->first;
+			left = qMin(left, i->second.first);
+			right = qMax(right, i->second.second);
+		}
+		emit dataChanged(createIndex(first, left), createIndex(last, right));
+	}
+}
+
+bool robotModel::inUpdate(void) const {
+	return _update_depth > 0;
+}
+
 /*!
 	Inserts a number of rows into the model at the specified position.
 */
@@ -231,13 +485,12 @@ bool robotModel::insertRows(int row, int count, const QModelIndex &parent) {
 	// signal that rows are being added
 	beginInsertRows(parent, row, row + count - 1);
 
-	// add new item to the list
-	for (int i = 0; i < count; i++) {
-		QStringList items;
-		for (int j = 0; j < NUM_COLUMNS; j++)
-			items.append("0");
-		_list.insert(row, items);
-	}
+	// add zeroed items with fresh ids
+	this->insert_rows(row, count);
+	this->shift_pending(row, count);
+	for (int i = row; i < row + count; i++)
+		_id[i] = _ids.allocate();
+	this->map_ids(row, _id.size());
 
 	// signal that rows have been added
 	endInsertRows();
@@ -253,9 +506,28 @@ bool robotModel::removeRows(int row, int count, const QModelIndex &parent) {
 	// signal that rows are being deleted
 	beginRemoveRows(parent, row, row + count - 1);
 
-	// delete items from the list
-	for (int i = 0; i < count; i++)
-		_list.removeAt(row);
+	// free ids of removed robots
+	for (int i = row; i < row + count; i++) {
+		this->unmap_id(i);
+		_ids.release(_id[i], this->id_block(_preconfig[i]));
+	}
+
+	// delete items from every column
+	_id.erase(_id.begin() + row, _id.begin() + row + count);
+	_form.erase(_form.begin() + row, _form.begin() + row + count);
+	_wheel.erase(_wheel.begin() + row, _wheel.begin() + row + count);
+	_preconfig.erase(_preconfig.begin() + row, _preconfig.begin() + row + count);
+	for (int i = 0; i < 3; i++) {
+		_p[i].erase(_p[i].begin() + row, _p[i].begin() + row + count);
+		_r[i].erase(_r[i].begin() + row, _r[i].begin() + row + count);
+	}
+	_radius.erase(_radius.begin() + row, _radius.begin() + row + count);
+	_labels.erase(_labels.begin() + row, _labels.begin() + row + count);
+	_index.removeRows(row, count);
+	this->shift_pending(row, -count);
+
+	// renumber following robots
+	this->map_ids(row, _id.size());
 
 	// signal that rows have been deleted
 	endRemoveRows();
@@ -263,3 +535,156 @@ bool robotModel::removeRows(int row, int count, const QModelIndex &parent) {
 	// success
 	return true;
 }
+
+/*!
+	Announces a block of changed cells, or merges it into the pending
+	changes of the current update.
+*/
+void robotModel::changed(int first, int last, int left, int right) {
+	if (_update_depth == 0) {
+		emit dataChanged(createIndex(first, left), createIndex(last, right));
+		return;
+	}
+	for (int row = first; row <= last; row++) {
+		std::map<int, QPair<int, int> >::iterator i = _pending.find(row);
+		if (i == _pending.end())
+			_pending[row] = qMakePair(left, right);
+		else {
+			i->second.first = qMin(i->second.first, left);
+			i->second.second = qMax(i->second.second, right);
+		}
+	}
+}
+
+/*!
+	Moves pending changes at or after row by delta rows, dropping those in
+	rows removed by a negative delta.
+*/
+void robotModel::shift_pending(int row, int delta) {
+	if (_pending.empty()) return;
+
+	std::map<int, QPair<int, int> > pending;
+	std::map<int, QPair<int, int> >::const_iterator i;
+	for (i = _pending.begin(); i != _pending.end(); ++i) {
+		if (i->first < row)
+			pending.insert(*i);
+		else if (delta > 0 || i->first >= row - delta)
+			pending[i->first + delta] = i->second;
+	}
+	_pending.swap(pending);
+}
+
+/*!
+	Returns the row of the robot with the given id, or -1. Ids inside the
+	block of a preconfigured robot map to its row.
+*/
+int robotModel::rowForId(int id) const {
+	return _id_rows.value(id, -1);
+}
+
+/*!
+	Returns the number of ids used by a robot with the given preconfig.
+*/
+int robotModel::id_block(int preconfig) const {
+	if (preconfig > 0 && preconfig < rsLinkbot::NUM_PRECONFIG)
+		return _l_preconfig[preconfig];
+	return 1;
+}
+
+/*!
+	Adds zeroed items to every column without assigning ids.
+*/
+void robotModel::insert_rows(int row, int count) {
+	_id.insert(_id.begin() + row, count, 0);
+	_form.insert(_form.begin() + row, count, 0);
+	_wheel.insert(_wheel.begin() + row, count, 0);
+	_preconfig.insert(_preconfig.begin() + row, count, 0);
+	for (int i = 0; i < 3; i++) {
+		_p[i].insert(_p[i].begin() + row, count, 0);
+		_r[i].insert(_r[i].begin() + row, count, 0);
+	}
+	_radius.insert(_radius.begin() + row, count, 0);
+	_labels.insert(_labels.begin() + row, count, QString());
+	_index.insertRows(row, count);
+}
+
+void robotModel::map_id(int row) {
+	int block = this->id_block(_preconfig[row]);
+	for (int i = 0; i < block; i++)
+		_id_rows.insert(_id[row] + i, row);
+}
+
+void robotModel::map_ids(int first, int last) {
+	for (int i = first; i < last; i++)
+		this->map_id(i);
+}
+
+void robotModel::unmap_id(int row) {
+	int block = this->id_block(_preconfig[row]);
+	for (int i = 0; i < block; i++)
+		_id_rows.remove(_id[row] + i);
+}
+
+/*!
+	Moves a robot to a new id and preconfig. A preconfig change that no
+	longer fits at the current id moves the robot to a free block; an
+	explicit id that is already taken is refused.
+*/
+bool robotModel::set_id(int row, int id, int preconfig) {
+	int old_id = _id[row];
+	int old_block = this->id_block(_preconfig[row]);
+	int block = this->id_block(preconfig);
+
+	this->unmap_id(row);
+	_ids.release(old_id, old_block);
+	if (!_ids.reserve(id, block)) {
+		if (id != old_id) {
+			_ids.reserve(old_id, old_block);
+			this->map_id(row);
+			return false;
+		}
+		id = _ids.allocate(block);
+	}
+	_id[row] = id;
+	_preconfig[row] = preconfig;
+	this->map_id(row);
+
+	return true;
+}
+
+/*!
+	Returns the integer storage for a column, or NULL for double columns.
+*/
+std::vector<int>* robotModel::int_column(int column) {
+	return const_cast<std::vector<int>*>(static_cast<const robotModel*>(this)->int_column(column));
+}
+
+const std::vector<int>* robotModel::int_column(int column) const {
+	switch (column) {
+		case ID:		return &_id;
+		case FORM:		return &_form;
+		case WHEEL:		return &_wheel;
+		case PRECONFIG:	return &_preconfig;
+		default:		return NULL;
+	}
+}
+
+/*!
+	Returns the double storage for a column, or NULL for integer columns.
+*/
+std::vector<double>* robotModel::double_column(int column) {
+	return const_cast<std::vector<double>*>(static_cast<const robotModel*>(this)->double_column(column));
+}
+
+const std::vector<double>* robotModel::double_column(int column) const {
+	switch (column) {
+		case P_X:		return &_p[0];
+		case P_Y:		return &_p[1];
+		case P_Z:		return &_p[2];
+		case R_PHI:		return &_r[0];
+		case R_THETA:	return &_r[1];
+		case R_PSI:		return &_r[2];
+		case RADIUS:	return &_radius;
+		default:		return NULL;
+	}
+}
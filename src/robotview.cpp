@@ -11,8 +11,17 @@ robotView::robotView(robotModel *model, QWidget *parent) : QListView(parent) {
 	this->setMovement(QListView::Static);
 	this->setResizeMode(QListView::Adjust);
 	this->setIconSize(QSize(48, 48));
+	model->setIconSize(this->iconSize());
 	this->setMinimumWidth(64);
 	this->setSpacing(12);
+
+	// every item has the same size, so only visible items are laid out
+	// and painted, and layout of large models runs in batches
+	this->setUniformItemSizes(true);
+	this->setGridSize(QSize(112, 88));
+	this->setWordWrap(true);
+	this->setLayoutMode(QListView::Batched);
+	this->setBatchSize(256);
 	this->setCurrentIndex(model->index(0, 0));
 	this->setModelColumn(rsModel::ID);
 
@@ -24,6 +33,11 @@ robotView::robotView(robotModel *model, QWidget *parent) : QListView(parent) {
 	this->setDragDropMode(QAbstractItemView::DropOnly);
 }
 
-void robotView::dataChanged(const QModelIndex &/*topLeft*/, const QModelIndex &bottomRight) {
-	this->setCurrentIndex(model()->index(bottomRight.row(), 0));
+void robotView::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+	// repaint changed items
+	QListView::dataChanged(topLeft, bottomRight);
+
+	// follow edits of a single robot, but keep position on bulk changes
+	if (topLeft.row() == bottomRight.row())
+		this->setCurrentIndex(model()->index(bottomRight.row(), 0));
 }
@@ -0,0 +1,71 @@
+#include <cstdio>
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "savefile.h"
+
+namespace {
+	// writes the file's data through to the disk
+	bool sync(int fd) {
+#ifdef _WIN32
+		return (_commit(fd) == 0);
+#else
+		return (fsync(fd) == 0);
+#endif
+	}
+
+	// replaces to with from in one step, or leaves both as they were
+	bool replace(const QString &from, const QString &to) {
+#ifdef _WIN32
+		return MoveFileExW(reinterpret_cast<const wchar_t*>(from.utf16()), reinterpret_cast<const wchar_t*>(to.utf16()),
+				MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+		return (std::rename(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0);
+#endif
+	}
+}
+
+saveFile::saveFile(const QString &fileName) : QFile(fileName + ".tmp") {
+	_target = fileName;
+	_committed = false;
+}
+
+saveFile::~saveFile(void) {
+	if (!_committed) {
+		this->close();
+		this->remove();
+	}
+}
+
+/*!
+	Opens the temporary file, truncated, in addition to the given mode.
+*/
+bool saveFile::open(OpenMode mode) {
+	return QFile::open(mode | QFile::WriteOnly | QFile::Truncate);
+}
+
+/*!
+	Flushes the temporary file to disk, closes it and renames it over the
+	target in one step. If the rename fails the target is left untouched
+	and false is returned.
+*/
+bool saveFile::commit(void) {
+	if (!this->isOpen() || !this->flush() || !sync(this->handle()))
+		return false;
+	this->close();
+	if (this->error() != QFile::NoError)
+		return false;
+
+	if (!replace(this->fileName(), _target))
+		return false;
+	_committed = true;
+	return true;
+}
+
+QString saveFile::targetName(void) const {
+	return _target;
+}
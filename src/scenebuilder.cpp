@@ -0,0 +1,259 @@
+#include <osg/Quat>
+
+#include "scenebuilder.h"
+
+namespace {
+	const double DEG2RAD = 0.017453292519943295;
+
+	int linkbotFace(int face) {
+		switch (face) {
+			case 1:		return rsRobots::LinkbotI::FACE1;
+			case 2:		return rsRobots::LinkbotI::FACE2;
+			default:	return rsRobots::LinkbotI::FACE3;
+		}
+	}
+
+	/*
+		Draws the connectors of one preconfig member. Wheels take the
+		connector chosen for the preconfigured robot.
+	*/
+	template <class T> void drawLinks(rsScene::Scene *scene, T *robot, rsScene::Robot *sceneRobot, const rsModel::PreconfigTemplate *t, int member, int wheel) {
+		for (int i = 0; i < t->num_links; i++) {
+			const rsModel::PreconfigLink &link = t->links[i];
+			int face = -1;
+			if (link.member == member)
+				face = linkbotFace(link.face);
+			else if (link.to_member == member)
+				face = linkbotFace(link.to_face);
+			else
+				continue;
+
+			// joined faces carry a plain faceplate on each side
+			scene->drawConnector(robot, sceneRobot, rs::SIMPLE, face, 0, 1, -1);
+			if (link.member == member && link.conn != rs::SIMPLE) {
+				int conn = (link.conn == rs::SMALLWHEEL) ? wheel : link.conn;
+				scene->drawConnector(robot, sceneRobot, rs::SIMPLE, face, 0, 2, conn);
+			}
+		}
+	}
+}
+
+/*!
+	Creates a builder with a private scene that is never attached to a
+	viewer, so robots can be drawn away from the GUI thread. When robots
+	are built through request(), the listener's robotsBuilt() slot is
+	invoked once finished robots are waiting in attachFinished().
+*/
+sceneBuilder::sceneBuilder(QObject *listener) {
+	_scene = new rsScene::Scene();
+	_listener = listener;
+	_done = false;
+}
+
+sceneBuilder::~sceneBuilder(void) {
+	// stop worker thread
+	if (this->isRunning()) {
+		_mutex.lock();
+		_done = true;
+		_condition.signal();
+		_mutex.unlock();
+		this->join();
+	}
+
+	this->clear();
+	delete _scene;
+}
+
+/*!
+	Drops every cached prototype and the robots used to draw them.
+*/
+void sceneBuilder::clear(void) {
+	_prototypes.clear();
+	for (unsigned int i = 0; i < _robots.size(); i++)
+		delete _robots[i];
+	_robots.clear();
+}
+
+/*!
+	Returns the shared subgraph for a robot form, wheel configuration and
+	preconfig. The subgraph is drawn once at the origin on first request
+	and must not be modified by callers; instances place it under their
+	own transform. A preconfigured robot is drawn as a single subgraph
+	holding all of its members. The prototype cache is not locked: call
+	this only while the worker thread is not used.
+*/
+osg::Node* sceneBuilder::getRobot(int form, int wheel, int preconfig) {
+	const rsModel::PreconfigTemplate *t = rsModel::preconfigTemplate(preconfig);
+	int conn = (form == rs::LINKBOTI || t) ? sceneBuilder::wheelConnector(wheel) : -1;
+	prototypeKey key((t) ? preconfig : 0, std::pair<int, int>(form, conn));
+	std::map<prototypeKey, osg::ref_ptr<osg::Node> >::iterator i = _prototypes.find(key);
+	if (i != _prototypes.end())
+		return i->second.get();
+
+	osg::Node *node = (t) ? this->build_preconfig(preconfig, wheel) : this->build_robot(form, wheel);
+	_prototypes[key] = node;
+	return node;
+}
+
+int sceneBuilder::getNumPrototypes(void) {
+	return _prototypes.size();
+}
+
+/*!
+	Adds every robot finished by the worker thread to the parent it was
+	requested for. Called from the update traversal so the scene graph
+	only changes at a frame boundary.
+*/
+void sceneBuilder::attachFinished(void) {
+	std::vector<buildJob> finished;
+	_mutex.lock();
+	finished.swap(_finished);
+	_mutex.unlock();
+
+	for (unsigned int i = 0; i < finished.size(); i++) {
+		if (finished[i].node.valid())
+			finished[i].parent->addChild(finished[i].node.get());
+	}
+}
+
+/*!
+	Queues a robot to be built on the worker thread and added to parent
+	by a later attachFinished().
+*/
+void sceneBuilder::request(osg::Group *parent, int form, int wheel, int preconfig) {
+	buildJob job;
+	job.parent = parent;
+	job.form = form;
+	job.wheel = wheel;
+	job.preconfig = preconfig;
+
+	_mutex.lock();
+	_pending.push_back(job);
+	_condition.signal();
+	_mutex.unlock();
+
+	if (!this->isRunning()) this->start();
+}
+
+void sceneBuilder::run(void) {
+	std::vector<buildJob> jobs;
+	while (true) {
+		// wait for work
+		_mutex.lock();
+		while (_pending.empty() && !_done)
+			_condition.wait(&_mutex);
+		if (_done) {
+			_mutex.unlock();
+			break;
+		}
+		jobs.swap(_pending);
+		_mutex.unlock();
+
+		// build robots
+		for (unsigned int i = 0; i < jobs.size(); i++)
+			jobs[i].node = this->getRobot(jobs[i].form, jobs[i].wheel, jobs[i].preconfig);
+
+		// hand over to the update traversal
+		_mutex.lock();
+		_finished.insert(_finished.end(), jobs.begin(), jobs.end());
+		_mutex.unlock();
+		jobs.clear();
+		if (_listener)
+			QMetaObject::invokeMethod(_listener, "robotsBuilt", Qt::QueuedConnection);
+	}
+}
+
+/*!
+	Maps the wheel selection of the robot editor to a connector type.
+*/
+int sceneBuilder::wheelConnector(int wheel) {
+	switch (wheel) {
+		case 1:		return rs::TINYWHEEL;
+		case 3:		return rs::BIGWHEEL;
+		default:	return rs::SMALLWHEEL;
+	}
+}
+
+/*!
+	Draws every member of a preconfig template with its connectors into
+	one group, posed relative to the preconfig origin.
+*/
+osg::Node* sceneBuilder::build_preconfig(int preconfig, int wheel) {
+	const rsModel::PreconfigTemplate *t = rsModel::preconfigTemplate(preconfig);
+	if (!t) return NULL;
+
+	osg::ref_ptr<osg::Group> group = new osg::Group();
+	for (int i = 0; i < t->num_members; i++) {
+		const rsModel::PreconfigMember &m = t->members[i];
+		osg::Quat q(m.r[0]*DEG2RAD, osg::Vec3d(1, 0, 0),
+					m.r[1]*DEG2RAD, osg::Vec3d(0, 1, 0),
+					m.r[2]*DEG2RAD, osg::Vec3d(0, 0, 1));
+		double quat[4] = {q.x(), q.y(), q.z(), q.w()};
+		osg::Node *node = this->draw_robot(m.form, wheel, m.p, quat, t, i);
+		if (node) group->addChild(node);
+	}
+	group->setDataVariance(osg::Object::STATIC);
+
+	return group.release();
+}
+
+osg::Node* sceneBuilder::build_robot(int form, int wheel) {
+	double pos[3] = {0, 0, 0};
+	double quat[4] = {0, 0, 0, 1};
+	return this->draw_robot(form, wheel, pos, quat);
+}
+
+/*!
+	Draws one robot at a pose and detaches it from the staging scene. For
+	a member of a preconfig template the connectors come from the
+	template, otherwise a Linkbot I gets its default wheels and caster.
+*/
+osg::Node* sceneBuilder::draw_robot(int form, int wheel, const double *p, const double *q, const rsModel::PreconfigTemplate *t, int member) {
+	double pos[3] = {p[0], p[1], p[2]};
+	double quat[4] = {q[0], q[1], q[2], q[3]};
+	rsScene::Robot *sceneRobot = NULL;
+	switch (form) {
+		case rs::LINKBOTI: {
+			rsRobots::LinkbotI *robot = new rsRobots::LinkbotI();
+			int conn = sceneBuilder::wheelConnector(wheel);
+			sceneRobot = _scene->drawRobot(robot, form, pos, quat, 1);
+			if (t)
+				drawLinks(_scene, robot, sceneRobot, t, member, conn);
+			else {
+				_scene->drawConnector(robot, sceneRobot, rs::SIMPLE, rsRobots::LinkbotI::FACE1, 0, 1, -1);
+				_scene->drawConnector(robot, sceneRobot, rs::SIMPLE, rsRobots::LinkbotI::FACE1, 0, 2, conn);
+				_scene->drawConnector(robot, sceneRobot, rs::SIMPLE, rsRobots::LinkbotI::FACE2, 0, 1, -1);
+				_scene->drawConnector(robot, sceneRobot, rs::SIMPLE, rsRobots::LinkbotI::FACE2, 0, 2, rs::CASTER);
+				_scene->drawConnector(robot, sceneRobot, rs::SIMPLE, rsRobots::LinkbotI::FACE3, 0, 1, -1);
+				_scene->drawConnector(robot, sceneRobot, rs::SIMPLE, rsRobots::LinkbotI::FACE3, 0, 2, conn);
+			}
+			_robots.push_back(robot);
+			break;
+		}
+		case rs::LINKBOTL: {
+			rsRobots::LinkbotL *robot = new rsRobots::LinkbotL();
+			sceneRobot = _scene->drawRobot(robot, form, pos, quat, 1);
+			if (t) drawLinks(_scene, robot, sceneRobot, t, member, sceneBuilder::wheelConnector(wheel));
+			_robots.push_back(robot);
+			break;
+		}
+		case rs::LINKBOTT: {
+			rsRobots::LinkbotT *robot = new rsRobots::LinkbotT();
+			sceneRobot = _scene->drawRobot(robot, form, pos, quat, 1);
+			if (t) drawLinks(_scene, robot, sceneRobot, t, member, sceneBuilder::wheelConnector(wheel));
+			_robots.push_back(robot);
+			break;
+		}
+		default:
+			break;
+	}
+	if (!sceneRobot) return NULL;
+
+	// take the drawn robot away from the scene staging area
+	osg::ref_ptr<osg::Node> node = sceneRobot;
+	while (node->getNumParents())
+		node->getParent(0)->removeChild(node.get());
+	node->setDataVariance(osg::Object::STATIC);
+
+	return node.release();
+}
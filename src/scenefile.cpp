@@ -0,0 +1,127 @@
+#include "scenefile.h"
+
+/*!
+	Loads and saves scenes in either the XML or the binary format. The
+	loader is chosen from the file header; converting between formats is
+	a load followed by a save. Saves go through a temporary file, and an
+	XML save streams the sections other than the robots from the XML file
+	that was loaded. Obstacles come from the obstacle model when one is
+	given, and the ground section is only rewritten if they changed.
+*/
+sceneFile::sceneFile(robotModel *model, obstacleModel *obstacles) {
+	_model = model;
+	_obstacle_model = obstacles;
+	_tracking = false;
+	_version = 0;
+}
+
+bool sceneFile::load(const QString &fileName) {
+	if (sceneFile::format(fileName) == rsModel::BINARY) {
+		binaryScene scene(_model, _obstacle_model);
+		if (!scene.read(fileName)) return false;
+		_source.clear();
+		_grid = scene.getGrid();
+		_obstacles = scene.getObstacles();
+		_robots = scene.getRobots();
+		_unknown.clear();
+		_tracking = scene.getTracking();
+		_version = scene.getVersion();
+	}
+	else {
+		xmlReader reader(_model, _obstacle_model);
+		if (!reader.read(fileName)) return false;
+		_source = fileName;
+		_grid = reader.getGrid();
+		_obstacles = reader.getObstacles();
+		_robots = reader.getRobots();
+		_unknown = reader.getUnknown();
+		_tracking = reader.getTracking();
+		_version = reader.getVersion();
+	}
+	return true;
+}
+
+bool sceneFile::save(const QString &fileName, int format) {
+	if (format == rsModel::BINARY) {
+		binaryScene scene(_model);
+		scene.setGrid(_grid);
+		scene.setObstacles((_obstacle_model) ? _obstacle_model->getObstacles() : _obstacles);
+		scene.setTracking(_tracking);
+		scene.setVersion(_version);
+		return scene.write(fileName);
+	}
+
+	// settings are unchanged since loading, so stream them from the source
+	xmlWriter writer(_model);
+	if (!_source.isEmpty() && QFile::exists(_source)) {
+		writer.setSource(_source);
+		if (this->obstacles_changed())
+			writer.setObstacles(_obstacle_model->getObstacles());
+	}
+	else {
+		writer.setGrid(_grid);
+		writer.setObstacles((_obstacle_model) ? _obstacle_model->getObstacles() : _obstacles);
+		writer.setTracking(_tracking);
+		writer.setVersion(_version);
+	}
+	return writer.write(fileName);
+}
+
+std::vector<double> sceneFile::getGrid(void) {
+	return _grid;
+}
+
+/*!
+	Returns the obstacles as stored in the file.
+*/
+const std::vector<rsModel::ObstacleSpec>& sceneFile::getObstacles(void) {
+	return _obstacles;
+}
+
+/*!
+	Returns the robots as stored in the file. The model may have given
+	some of them new ids.
+*/
+const std::vector<rsModel::RobotSpec>& sceneFile::getRobots(void) {
+	return _robots;
+}
+
+const std::vector<rsModel::UnknownElement>& sceneFile::getUnknown(void) {
+	return _unknown;
+}
+
+bool sceneFile::getTracking(void) {
+	return _tracking;
+}
+
+int sceneFile::getVersion(void) {
+	return _version;
+}
+
+/*!
+	Returns the format of a scene file from its header.
+*/
+int sceneFile::format(const QString &fileName) {
+	return (binaryScene::isBinary(fileName)) ? rsModel::BINARY : rsModel::XML;
+}
+
+/*!
+	Returns true if the obstacle model differs from the obstacles loaded
+	from the file.
+*/
+bool sceneFile::obstacles_changed(void) const {
+	if (!_obstacle_model) return false;
+	const std::vector<rsModel::ObstacleSpec> &obstacles = _obstacle_model->getObstacles();
+	if (obstacles.size() != _obstacles.size()) return true;
+	for (unsigned int i = 0; i < obstacles.size(); i++) {
+		const rsModel::ObstacleSpec &a = obstacles[i], &b = _obstacles[i];
+		if (a.type != b.type || a.mass != b.mass) return true;
+		for (int j = 0; j < 3; j++) {
+			if (a.p[j] != b.p[j] || a.r[j] != b.r[j] || a.l[j] != b.l[j]) return true;
+		}
+		for (int j = 0; j < 4; j++) {
+			if (a.c[j] != b.c[j]) return true;
+		}
+	}
+	return false;
+}
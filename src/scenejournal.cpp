@@ -0,0 +1,454 @@
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <QBuffer>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QTimer>
+
+#include "binaryscene.h"
+#include "savefile.h"
+#include "scenejournal.h"
+
+using namespace rsModel;
+
+namespace {
+	const char magic[4] = {'R', 'S', 'J', 'L'};
+	const quint32 version = 2;
+	const quint32 byte_order = 0x01020304;
+
+	void encode(QByteArray &data, int op, int row, int arg, const void *payload, quint32 size) {
+		JournalEntry entry;
+		entry.op = op;
+		entry.row = row;
+		entry.arg = arg;
+		entry.size = size;
+		data.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+		if (size) data.append(reinterpret_cast<const char*>(payload), size);
+	}
+}
+
+/*!
+	Creates a journal for the scene in fileName. The journal and snapshot
+	are kept beside it as fileName.journal and fileName.snapshot.
+*/
+sceneJournal::sceneJournal(robotModel *model, const QString &fileName, QObject *parent) : QObject(parent) {
+	_model = model;
+	_file_name = fileName;
+	_journal_name = fileName + ".journal";
+	_snapshot_name = fileName + ".snapshot";
+	_generation = 0;
+	_base_size = -1;
+	_base_mtime = -1;
+	_size = 0;
+	_compact_size = 4*1024*1024;
+	_compact_pending = false;
+	_restored = false;
+	_done = false;
+}
+
+sceneJournal::~sceneJournal(void) {
+	// write what is left and stop writer thread
+	if (this->isRunning()) {
+		_mutex.lock();
+		_done = true;
+		_condition.signal();
+		_mutex.unlock();
+		this->join();
+	}
+	_file.close();
+}
+
+/*!
+	Starts journaling edits of the model. If replay() restored any edits,
+	they are first folded into a new snapshot so the journal starts
+	empty.
+*/
+bool sceneJournal::attach(void) {
+	if (this->isRunning()) return true;
+
+	// the scene file as it is now is the base of everything journaled
+	this->base_identity(&_base_size, &_base_mtime);
+
+	bool ok = true;
+	if (_restored) {
+		_generation++;
+		binaryScene snapshot(_model);
+		snapshot.setTag(_generation);
+		ok = snapshot.write(_snapshot_name);
+	}
+	else {
+		_generation = 0;
+		QFile::remove(_snapshot_name);
+	}
+	if (!this->reset_journal(_generation) || !ok) {
+		std::cerr << "Error: Cannot write journal " << qPrintable(_journal_name) << std::endl;
+		return false;
+	}
+	_size = sizeof(JournalHeader);
+
+	// follow model changes
+	QObject::connect(_model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SLOT(dataChanged(const QModelIndex&, const QModelIndex&)));
+	QObject::connect(_model, SIGNAL(rowsInserted(QModelIndex, int, int)), this, SLOT(rowsInserted(const QModelIndex&, int, int)));
+	QObject::connect(_model, SIGNAL(rowsRemoved(QModelIndex, int, int)), this, SLOT(rowsRemoved(const QModelIndex&, int, int)));
+
+	this->start();
+	return true;
+}
+
+/*!
+	Restores edits left by an earlier session into the model: the
+	snapshot if there is a current one, then the edits journaled after
+	it. Must be called before attach(). Returns true if anything was
+	restored. A journal recorded against a scene file that has changed
+	since is dropped, since its rows no longer match the model.
+*/
+bool sceneJournal::replay(void) {
+	// generation of journal
+	qint64 journal = -1;
+	QFile file(_journal_name);
+	JournalHeader header;
+	if (file.open(QFile::ReadOnly) &&
+		file.read(reinterpret_cast<char*>(&header), sizeof(header)) == sizeof(header) &&
+		!memcmp(header.magic, magic, sizeof(magic)) &&
+		header.version == version && header.byte_order == byte_order)
+		journal = header.generation;
+	file.close();
+
+	// journal must belong to the scene file as it is now
+	qint64 size, mtime;
+	this->base_identity(&size, &mtime);
+	if (journal >= 0 && (header.base_size != size || header.base_mtime != mtime)) {
+		std::cerr << "Warning: Dropping journal " << qPrintable(_journal_name)
+				  << " recorded against an older version of " << qPrintable(_file_name) << std::endl;
+		QFile::remove(_journal_name);
+		QFile::remove(_snapshot_name);
+		return false;
+	}
+
+	// generation of snapshot
+	quint32 tag = 0;
+	QFile snapshot_file(_snapshot_name);
+	SceneHeader scene;
+	if (snapshot_file.open(QFile::ReadOnly) &&
+		snapshot_file.read(reinterpret_cast<char*>(&scene), sizeof(scene)) == sizeof(scene))
+		tag = scene.tag;
+	snapshot_file.close();
+
+	// restore snapshot
+	_generation = 0;
+	if (tag > 0 && journal <= tag) {
+		robotModelUpdate update(_model);
+		if (_model->rowCount())
+			_model->removeRows(0, _model->rowCount());
+		binaryScene snapshot(_model);
+		if (!snapshot.read(_snapshot_name))
+			return false;
+		_generation = tag;
+		_restored = true;
+		if (journal < tag) return true;
+	}
+	else if (journal > 0) {
+		std::cerr << "Warning: Ignoring journal " << qPrintable(_journal_name) << " without its snapshot" << std::endl;
+		return false;
+	}
+	else if (journal < 0)
+		return false;
+
+	// restore journaled edits
+	quint32 entries = 0;
+	this->replay_journal(&entries);
+	if (entries) _restored = true;
+	return _restored;
+}
+
+/*!
+	Sets the journal size at which the model is written as a snapshot.
+*/
+void sceneJournal::setCompactSize(qint64 size) {
+	_compact_size = size;
+}
+
+/*!
+	Drops the journal and snapshot, for instance after the scene was
+	saved, so the scene file becomes the base again.
+*/
+void sceneJournal::clear(void) {
+	_file_mutex.lock();
+	_mutex.lock();
+	_pending.clear();
+	_snapshot.clear();
+	_generation = 0;
+	_mutex.unlock();
+	_inserted.clear();
+	this->base_identity(&_base_size, &_base_mtime);
+	QFile::remove(_snapshot_name);
+	this->reset_journal(0);
+	_size = sizeof(JournalHeader);
+	_file_mutex.unlock();
+}
+
+/*!
+	Copies the model into a snapshot of the next generation and hands it
+	to the writer thread, which writes it and starts an empty journal on
+	top of it. Edits not yet written are covered by the snapshot and
+	dropped.
+*/
+void sceneJournal::compact(void) {
+	_compact_pending = false;
+
+	_mutex.lock();
+	quint32 generation = _generation + 1;
+	_mutex.unlock();
+
+	QByteArray data;
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::WriteOnly);
+	binaryScene snapshot(_model);
+	snapshot.setTag(generation);
+	if (!snapshot.write(&buffer)) {
+		std::cerr << "Error: Cannot compact journal " << qPrintable(_journal_name) << std::endl;
+		return;
+	}
+	buffer.close();
+
+	_mutex.lock();
+	_pending.clear();
+	_snapshot.swap(data);
+	_generation = generation;
+	_condition.signal();
+	_mutex.unlock();
+	_inserted.clear();
+	_size = sizeof(JournalHeader);
+}
+
+/*!
+	Journals the changed cells. The model announces inserted rows as
+	changed as well, so cells of freshly inserted rows that still hold the
+	value their insert entry recorded are skipped.
+*/
+void sceneJournal::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+	QByteArray data;
+	for (int i = topLeft.row(); i <= bottomRight.row(); i++) {
+		std::map<int, std::vector<double> >::iterator inserted = _inserted.find(i);
+		for (int j = topLeft.column(); j <= bottomRight.column(); j++) {
+			double value = this->value(i, j);
+			if (inserted != _inserted.end() && inserted->second[j] == value) continue;
+			encode(data, JOURNAL_SET, i, j, &value, sizeof(value));
+		}
+		if (inserted != _inserted.end()) _inserted.erase(inserted);
+	}
+	if (!data.isEmpty()) this->append(data);
+}
+
+void sceneJournal::rowsInserted(const QModelIndex&, int first, int last) {
+	this->shift_inserted(first, last - first + 1);
+	std::vector<RobotRecord> records(last - first + 1);
+	for (int i = first; i <= last; i++) {
+		std::vector<double> &values = _inserted[i];
+		values.resize(NUM_COLUMNS);
+		for (int j = 0; j < NUM_COLUMNS; j++)
+			values[j] = this->value(i, j);
+
+		RobotRecord &r = records[i - first];
+		memset(&r, 0, sizeof(r));
+		r.id = _model->getInt(i, ID);
+		r.form = _model->getInt(i, FORM);
+		_model->getPosition(i, r.p);
+		_model->getRotation(i, r.r);
+		r.radius = _model->getDouble(i, RADIUS);
+		r.wheel = _model->getInt(i, WHEEL);
+		r.preconfig = _model->getInt(i, PRECONFIG);
+	}
+	QByteArray data;
+	encode(data, JOURNAL_INSERT, first, records.size(), &records[0], records.size()*sizeof(RobotRecord));
+	this->append(data);
+}
+
+void sceneJournal::rowsRemoved(const QModelIndex&, int first, int last) {
+	this->shift_inserted(first, -(last - first + 1));
+	QByteArray data;
+	encode(data, JOURNAL_REMOVE, first, last - first + 1, NULL, 0);
+	this->append(data);
+}
+
+void sceneJournal::run(void) {
+	QByteArray data, snapshot;
+	while (true) {
+		// wait for edits or a snapshot
+		_mutex.lock();
+		while (_pending.isEmpty() && _snapshot.isEmpty() && !_done)
+			_condition.wait(&_mutex);
+		if (_pending.isEmpty() && _snapshot.isEmpty() && _done) {
+			_mutex.unlock();
+			break;
+		}
+		data.swap(_pending);
+		snapshot.swap(_snapshot);
+		quint32 generation = _generation;
+		_mutex.unlock();
+
+		// edits taken before a clear or a newer compaction are outdated
+		_file_mutex.lock();
+		_mutex.lock();
+		bool current = (generation == _generation);
+		_mutex.unlock();
+		if (current && !snapshot.isEmpty() && !this->write_snapshot(snapshot, generation)) {
+			// a journal of the old generation must not get the new edits
+			std::cerr << "Error: Cannot compact journal " << qPrintable(_journal_name) << std::endl;
+			_file.close();
+		}
+		if (current && _file.isOpen()) {
+			_file.write(data);
+			_file.flush();
+		}
+		_file_mutex.unlock();
+		data.clear();
+		snapshot.clear();
+	}
+}
+
+/*!
+	Queues encoded edits for the writer thread and schedules a compaction
+	once the journal is large.
+*/
+void sceneJournal::append(const QByteArray &data) {
+	if (data.isEmpty()) return;
+
+	_mutex.lock();
+	_pending.append(data);
+	_condition.signal();
+	_mutex.unlock();
+
+	_size += data.size();
+	if (_size > _compact_size && !_compact_pending) {
+		_compact_pending = true;
+		QTimer::singleShot(0, this, SLOT(compact()));
+	}
+}
+
+/*!
+	Returns the size and modification time of the scene file, or -1 if
+	it does not exist.
+*/
+void sceneJournal::base_identity(qint64 *size, qint64 *mtime) const {
+	QFileInfo info(_file_name);
+	*size = (info.exists()) ? info.size() : -1;
+	*mtime = (info.exists()) ? info.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+/*!
+	Applies the entries of the journal file to the model as one update,
+	stopping at the first incomplete or invalid entry.
+*/
+void sceneJournal::replay_journal(quint32 *entries) {
+	*entries = 0;
+	QFile file(_journal_name);
+	if (!file.open(QFile::ReadOnly)) return;
+	QByteArray data = file.readAll();
+	file.close();
+
+	robotModelUpdate update(_model);
+	int offset = sizeof(JournalHeader);
+	while (offset + static_cast<int>(sizeof(JournalEntry)) <= data.size()) {
+		JournalEntry entry;
+		memcpy(&entry, data.constData() + offset, sizeof(entry));
+		offset += sizeof(entry);
+		if (entry.size > static_cast<quint32>(data.size() - offset))
+			break;
+		const char *payload = data.constData() + offset;
+		offset += entry.size;
+
+		int rows = _model->rowCount();
+		if (entry.op == JOURNAL_SET && entry.size == sizeof(double) && entry.row >= 0 && entry.row < rows &&
+				entry.arg >= 0 && entry.arg < NUM_COLUMNS) {
+			double value;
+			memcpy(&value, payload, sizeof(value));
+			if (rsModel::isIntColumn(entry.arg))
+				_model->setInt(entry.row, entry.arg, static_cast<int>(value));
+			else
+				_model->setDouble(entry.row, entry.arg, value);
+		}
+		else if (entry.op == JOURNAL_INSERT && entry.arg > 0 && entry.row >= 0 && entry.row <= rows &&
+				entry.size == entry.arg*sizeof(RobotRecord)) {
+			std::vector<RobotSpec> specs(entry.arg);
+			for (int i = 0; i < entry.arg; i++) {
+				RobotRecord r;
+				memcpy(&r, payload + i*sizeof(RobotRecord), sizeof(r));
+				RobotSpec &s = specs[i];
+				s.id = r.id;
+				s.form = r.form;
+				memcpy(s.p, r.p, sizeof(s.p));
+				memcpy(s.r, r.r, sizeof(s.r));
+				s.radius = r.radius;
+				s.wheel = r.wheel;
+				s.preconfig = r.preconfig;
+			}
+			_model->insertRobots(entry.row, &specs[0], entry.arg);
+		}
+		else if (entry.op == JOURNAL_REMOVE && entry.size == 0 && entry.row >= 0 && entry.arg > 0 &&
+				entry.row + entry.arg <= rows)
+			_model->removeRows(entry.row, entry.arg);
+		else
+			break;
+		(*entries)++;
+	}
+}
+
+/*!
+	Truncates the journal file to a header for the given generation.
+*/
+bool sceneJournal::reset_journal(quint32 generation) {
+	_file.close();
+	_file.setFileName(_journal_name);
+	if (!_file.open(QFile::WriteOnly | QFile::Truncate))
+		return false;
+
+	JournalHeader header;
+	memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.byte_order = byte_order;
+	header.generation = generation;
+	header.base_size = _base_size;
+	header.base_mtime = _base_mtime;
+	bool ok = (_file.write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header));
+	_file.flush();
+	return ok;
+}
+
+/*!
+	Writes a snapshot prepared by compact() and truncates the journal to
+	its generation. Runs on the writer thread with _file_mutex held.
+*/
+bool sceneJournal::write_snapshot(const QByteArray &data, quint32 generation) {
+	saveFile file(_snapshot_name);
+	if (!file.open(QFile::WriteOnly) || file.write(data) != data.size() || !file.commit())
+		return false;
+	return this->reset_journal(generation);
+}
+
+/*!
+	Moves the journaled values of inserted rows at or after row by delta
+	rows, dropping those in rows removed by a negative delta.
+*/
+void sceneJournal::shift_inserted(int row, int delta) {
+	if (_inserted.empty()) return;
+
+	std::map<int, std::vector<double> > inserted;
+	std::map<int, std::vector<double> >::iterator i;
+	for (i = _inserted.begin(); i != _inserted.end(); ++i) {
+		if (i->first < row)
+			inserted[i->first].swap(i->second);
+		else if (delta > 0 || i->first >= row - delta)
+			inserted[i->first + delta].swap(i->second);
+	}
+	_inserted.swap(inserted);
+}
+
+/*!
+	Returns a cell of the model as it is journaled.
+*/
+double sceneJournal::value(int row, int column) const {
+	return (rsModel::isIntColumn(column)) ? _model->getInt(row, column) : _model->getDouble(row, column);
+}
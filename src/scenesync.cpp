@@ -0,0 +1,261 @@
+#include <osg/Material>
+#include <osg/NodeCallback>
+
+#include "scenesync.h"
+
+/*!
+	Update callback that attaches robots finished by the builder thread
+	while the viewer is between frames.
+*/
+class attachCallback : public osg::NodeCallback {
+	public:
+		attachCallback(sceneBuilder *builder) : _builder(builder) {}
+
+		virtual void operator()(osg::Node *node, osg::NodeVisitor *nv) {
+			_builder->attachFinished();
+			traverse(node, nv);
+		}
+
+	private:
+		sceneBuilder *_builder;
+};
+
+sceneSync::sceneSync(QObject *parent) : QObject(parent) {
+	// robot geometry shared between instances
+	_builder = new sceneBuilder(this);
+	_model = NULL;
+	_current = -1;
+	_async = true;
+
+	// root of all robots managed by this layer
+	_root = new osg::Group();
+	_root->setUpdateCallback(new attachCallback(_builder));
+
+	// shared highlight effect
+	_highlight = new osgFX::Scribe();
+	_highlight->setWireframeColor(osg::Vec4(1, 1, 0, 1));
+}
+
+sceneSync::~sceneSync(void) {
+	_root->setUpdateCallback(NULL);
+	delete _builder;
+}
+
+osg::Group* sceneSync::getRoot(void) {
+	return _root.get();
+}
+
+/*!
+	Chooses whether robot geometry is built on the builder thread and
+	attached at the next frame, or built immediately on the calling
+	thread. Must be set before the first robot is built.
+*/
+void sceneSync::setAsync(bool async) {
+	_async = async;
+}
+
+void sceneSync::setModel(robotModel *model) {
+	// set model
+	_model = model;
+
+	// follow model changes
+	QObject::connect(_model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SLOT(dataChanged(const QModelIndex&, const QModelIndex&)));
+	QObject::connect(_model, SIGNAL(rowsInserted(QModelIndex, int, int)), this, SLOT(rowsInserted(const QModelIndex&, int, int)));
+	QObject::connect(_model, SIGNAL(rowsRemoved(QModelIndex, int, int)), this, SLOT(rowsRemoved(const QModelIndex&, int, int)));
+
+	// build robots already in the model
+	_nodes.resize(_model->rowCount());
+	if (_model->rowCount())
+		this->dataChanged(_model->index(0, 0), _model->index(_model->rowCount()-1, rsModel::NUM_COLUMNS-1));
+}
+
+/*!
+	Brings the scene nodes of the changed rows up to date. Rows without a
+	node and rows whose id, form, wheel or preconfig differ from what was
+	drawn get a new instance; rows where only the pose changed just have their
+	transform updated.
+*/
+void sceneSync::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+	bool pose = (topLeft.column() <= rsModel::R_PSI && bottomRight.column() >= rsModel::P_X);
+
+	for (int i = topLeft.row(); i <= bottomRight.row() && i < static_cast<int>(_nodes.size()); i++) {
+		if (this->needs_rebuild(i))
+			this->build_robot(i);
+		else if (pose)
+			this->update_transform(i);
+	}
+
+	// set current robot
+	this->setCurrentIndex(bottomRight);
+
+	// signal redraw
+	emit sceneChanged();
+}
+
+void sceneSync::rowsInserted(const QModelIndex&, int first, int last) {
+	// reserve empty slots; nodes are built on the following dataChanged()
+	_nodes.insert(_nodes.begin() + first, last - first + 1, robotNode());
+	if (_current >= first) _current += last - first + 1;
+}
+
+void sceneSync::rowsRemoved(const QModelIndex&, int first, int last) {
+	// detach nodes of removed rows
+	for (int i = first; i <= last; i++) {
+		if (i == _current) this->set_highlight(i, false);
+		if (_nodes[i].transform.valid())
+			_root->removeChild(_nodes[i].transform.get());
+	}
+	_nodes.erase(_nodes.begin() + first, _nodes.begin() + last + 1);
+
+	// update current robot
+	if (_current > last) _current -= last - first + 1;
+	else if (_current >= first) _current = -1;
+
+	// signal redraw
+	emit sceneChanged();
+}
+
+/*!
+	Makes a robot picked in the scene the current one and tells the views.
+*/
+void sceneSync::pickRobot(int row) {
+	if (!_model || row < 0 || row >= static_cast<int>(_nodes.size())) return;
+
+	QModelIndex index = _model->index(row, 0);
+	this->setCurrentIndex(index);
+	emit robotPicked(index);
+}
+
+/*!
+	Moves the node of a robot on the ground without touching the model,
+	so a drag follows the cursor at frame rate. The model is updated once
+	the drag ends, which puts the node back in sync.
+*/
+void sceneSync::previewPose(int row, double x, double y, double psi) {
+	if (!_model || row < 0 || row >= static_cast<int>(_nodes.size()) || !_nodes[row].transform.valid()) return;
+
+	double p[3], r[3];
+	_model->getPosition(row, p);
+	_model->getRotation(row, r);
+	p[0] = x;
+	p[1] = y;
+	r[2] = psi;
+	this->set_transform(row, p, r);
+}
+
+void sceneSync::robotsBuilt(void) {
+	// finished robots are attached during the next frame
+	emit sceneChanged();
+}
+
+void sceneSync::setCurrentIndex(const QModelIndex &index) {
+	// do nothing when indices are the same
+	if (_current == index.row()) return;
+
+	// move highlight to new current robot
+	if (_current >= 0 && _current < static_cast<int>(_nodes.size()))
+		this->set_highlight(_current, false);
+	_current = index.row();
+	if (_current >= 0 && _current < static_cast<int>(_nodes.size()))
+		this->set_highlight(_current, true);
+
+	// signal redraw
+	emit sceneChanged();
+}
+
+/*!
+	Places the shared geometry for the robot of a row under a new
+	per-instance transform and colour, replacing any node previously
+	built for the row.
+*/
+void sceneSync::build_robot(int row) {
+	robotNode &node = _nodes[row];
+	bool highlighted = (row == _current && node.transform.valid());
+	if (highlighted) this->set_highlight(row, false);
+
+	node.id = _model->getInt(row, rsModel::ID);
+	node.form = _model->getInt(row, rsModel::FORM);
+	node.wheel = _model->getInt(row, rsModel::WHEEL);
+	node.preconfig = _model->getInt(row, rsModel::PRECONFIG);
+	node.radius = _model->getDouble(row, rsModel::RADIUS);
+
+	// per-instance state
+	osg::ref_ptr<osg::PositionAttitudeTransform> transform = new osg::PositionAttitudeTransform();
+	osg::Material *material = new osg::Material();
+	material->setDiffuse(osg::Material::FRONT_AND_BACK, sceneSync::instance_color(node.id));
+	transform->getOrCreateStateSet()->setAttribute(material);
+
+	// add shared geometry now or once the builder thread has it
+	if (_async)
+		_builder->request(transform.get(), node.form, node.wheel, node.preconfig);
+	else {
+		osg::Node *robot = _builder->getRobot(node.form, node.wheel, node.preconfig);
+		if (robot) transform->addChild(robot);
+	}
+
+	// swap in the new instance
+	if (node.transform.valid())
+		_root->replaceChild(node.transform.get(), transform.get());
+	else
+		_root->addChild(transform.get());
+	node.transform = transform;
+	this->update_transform(row);
+
+	if (highlighted) this->set_highlight(row, true);
+}
+
+/*!
+	Returns the instance colour for a robot id, cycling through a fixed
+	palette so neighbouring robots are told apart.
+*/
+osg::Vec4 sceneSync::instance_color(int id) {
+	static const osg::Vec4 palette[] = {
+		osg::Vec4(0.0, 0.0, 1.0, 1.0),
+		osg::Vec4(1.0, 0.0, 0.0, 1.0),
+		osg::Vec4(0.0, 1.0, 0.0, 1.0),
+		osg::Vec4(1.0, 1.0, 0.0, 1.0),
+		osg::Vec4(1.0, 0.0, 1.0, 1.0),
+		osg::Vec4(0.0, 1.0, 1.0, 1.0),
+	};
+	return palette[((id % 6) + 6) % 6];
+}
+
+bool sceneSync::needs_rebuild(int row) const {
+	const robotNode &node = _nodes[row];
+	return (!node.transform.valid() ||
+			node.id != _model->getInt(row, rsModel::ID) ||
+			node.form != _model->getInt(row, rsModel::FORM) ||
+			node.wheel != _model->getInt(row, rsModel::WHEEL) ||
+			node.preconfig != _model->getInt(row, rsModel::PRECONFIG) ||
+			node.radius != _model->getDouble(row, rsModel::RADIUS));
+}
+
+void sceneSync::set_highlight(int row, bool on) {
+	osg::PositionAttitudeTransform *transform = _nodes[row].transform.get();
+	if (!transform) return;
+
+	if (on) {
+		_highlight->removeChildren(0, _highlight->getNumChildren());
+		_highlight->addChild(transform);
+		_root->replaceChild(transform, _highlight.get());
+	}
+	else if (_highlight->containsNode(transform)) {
+		_root->replaceChild(_highlight.get(), transform);
+		_highlight->removeChildren(0, _highlight->getNumChildren());
+	}
+}
+
+void sceneSync::set_transform(int row, const double *p, const double *r) {
+	osg::PositionAttitudeTransform *transform = _nodes[row].transform.get();
+	transform->setPosition(osg::Vec3d(p[0], p[1], p[2] + 0.04445));
+	transform->setAttitude(osg::Quat(osg::DegreesToRadians(r[0]), osg::Vec3d(1, 0, 0),
+									 osg::DegreesToRadians(r[1]), osg::Vec3d(0, 1, 0),
+									 osg::DegreesToRadians(r[2]), osg::Vec3d(0, 0, 1)));
+}
+
+void sceneSync::update_transform(int row) {
+	double p[3], r[3];
+	_model->getPosition(row, p);
+	_model->getRotation(row, r);
+	this->set_transform(row, p, r);
+}
@@ -0,0 +1,319 @@
+#include <algorithm>
+
+#include <QList>
+#include <QtConcurrentMap>
+
+#include "scenevalidator.h"
+
+using namespace rsModel;
+
+namespace {
+	const double DEG2RAD = 0.017453292519943295;
+}
+
+/*
+	Checks one chunk of rows on a worker thread. The validator is only
+	read while the chunks run.
+*/
+struct sceneValidator::checker {
+	typedef std::vector<Diagnostic> result_type;
+	checker(const sceneValidator *validator) : _validator(validator) {}
+	std::vector<Diagnostic> operator()(const chunk &c) const {
+		std::vector<Diagnostic> diagnostics;
+		if (c.target == ROBOT)
+			_validator->check_robots(c, diagnostics);
+		else
+			_validator->check_obstacles(c, diagnostics);
+		return diagnostics;
+	}
+	const sceneValidator *_validator;
+};
+
+sceneValidator::sceneValidator(void) {
+	_grid = NULL;
+	_obstacles = NULL;
+	_robots = NULL;
+	_unknown = NULL;
+	_chunk_size = 2048;
+}
+
+/*!
+	Sets the grid as tics, major, min x, max x, min y, max y and enabled.
+	Positions are only checked against a grid with a non-empty area.
+*/
+void sceneValidator::setGrid(const std::vector<double> &grid) {
+	_grid = &grid;
+}
+
+void sceneValidator::setObstacles(const std::vector<ObstacleSpec> &obstacles) {
+	_obstacles = &obstacles;
+}
+
+/*!
+	Sets the robots to check, as read from the file so that duplicate ids
+	are still present.
+*/
+void sceneValidator::setRobots(const std::vector<RobotSpec> &robots) {
+	_robots = &robots;
+}
+
+void sceneValidator::setUnknown(const std::vector<UnknownElement> &unknown) {
+	_unknown = &unknown;
+}
+
+/*!
+	Sets the number of rows checked by one task.
+*/
+void sceneValidator::setChunkSize(int size) {
+	_chunk_size = qMax(size, 1);
+}
+
+/*!
+	Runs all checks and returns the diagnostics: robots first, then
+	obstacles, then skipped elements, each in row order.
+*/
+const std::vector<Diagnostic>& sceneValidator::validate(void) {
+	_diagnostics.clear();
+	this->prepare();
+
+	// split rows into chunks
+	QList<chunk> chunks;
+	int rows[2] = {(_robots) ? static_cast<int>(_robots->size()) : 0,
+				   (_obstacles) ? static_cast<int>(_obstacles->size()) : 0};
+	int targets[2] = {ROBOT, OBSTACLE};
+	for (int t = 0; t < 2; t++) {
+		for (int i = 0; i < rows[t]; i += _chunk_size) {
+			chunk c;
+			c.target = targets[t];
+			c.begin = i;
+			c.end = qMin(i + _chunk_size, rows[t]);
+			chunks.append(c);
+		}
+	}
+
+	// check chunks on the thread pool and collect them in order
+	if (!chunks.isEmpty()) {
+		QFuture<std::vector<Diagnostic> > future = QtConcurrent::mapped(chunks, checker(this));
+		future.waitForFinished();
+		for (int i = 0; i < future.resultCount(); i++) {
+			const std::vector<Diagnostic> &result = future.resultAt(i);
+			_diagnostics.insert(_diagnostics.end(), result.begin(), result.end());
+		}
+	}
+
+	// skipped elements
+	for (unsigned int i = 0; _unknown && i < _unknown->size(); i++) {
+		Diagnostic d;
+		d.check = UNKNOWN_ELEMENT;
+		d.target = ELEMENT;
+		d.row = i;
+		_diagnostics.push_back(d);
+	}
+
+	return _diagnostics;
+}
+
+const std::vector<Diagnostic>& sceneValidator::getDiagnostics(void) const {
+	return _diagnostics;
+}
+
+int sceneValidator::errorCount(void) const {
+	int count = 0;
+	for (unsigned int i = 0; i < _diagnostics.size(); i++) {
+		if (_diagnostics[i].severity == SEVERITY_ERROR)
+			count++;
+	}
+	return count;
+}
+
+/*!
+	Returns a one line description of a diagnostic.
+*/
+QString sceneValidator::describe(const Diagnostic &d) const {
+	QString where;
+	if (d.target == ROBOT)
+		where = QString("robot row %1").arg(d.row);
+	else if (d.target == OBSTACLE)
+		where = QString("obstacle row %1").arg(d.row);
+	else if (_unknown && d.row >= 0 && d.row < static_cast<int>(_unknown->size()))
+		where = QString("line %1").arg((*_unknown)[d.row].line);
+	QString level = (d.severity == SEVERITY_ERROR) ? "error" : "warning";
+
+	QString what;
+	switch (d.check) {
+		case DUPLICATE_ID:
+			what = QString("duplicate id %1, first used by robot row %2").arg(d.value).arg(d.other);
+			break;
+		case UNKNOWN_FORM:
+			what = QString("unknown form %1").arg(d.value);
+			break;
+		case UNDRAWABLE_FORM:
+			what = QString("form %1 cannot be drawn").arg(d.value);
+			break;
+		case UNKNOWN_SHAPE:
+			what = QString("unknown obstacle type %1").arg(d.value);
+			break;
+		case UNKNOWN_ELEMENT:
+			if (_unknown && d.row >= 0 && d.row < static_cast<int>(_unknown->size()))
+				what = QString("unknown element <%1> skipped").arg((*_unknown)[d.row].name);
+			break;
+		case ROBOT_OVERLAP:
+			what = QString("overlaps robot row %1").arg(d.other);
+			break;
+		case OBSTACLE_OVERLAP:
+			what = QString("overlaps obstacle row %1").arg(d.other);
+			break;
+		case OUT_OF_GRID:
+			what = "outside of the grid";
+			break;
+		default:
+			break;
+	}
+	return QString("%1: %2: %3").arg(where).arg(level).arg(what);
+}
+
+void sceneValidator::check_obstacles(const chunk &c, std::vector<Diagnostic> &diagnostics) const {
+	for (int i = c.begin; i < c.end; i++) {
+		const ObstacleSpec &o = (*_obstacles)[i];
+		Diagnostic d;
+		d.target = OBSTACLE;
+		d.row = i;
+
+		if (o.type != rs::BOX && o.type != rs::CYLINDER && o.type != rs::SPHERE) {
+			d.check = UNKNOWN_SHAPE;
+			d.value = o.type;
+			diagnostics.push_back(d);
+		}
+		if (!this->in_grid(o.p[0], o.p[1])) {
+			d.check = OUT_OF_GRID;
+			d.severity = SEVERITY_WARNING;
+			d.value = 0;
+			diagnostics.push_back(d);
+		}
+	}
+}
+
+void sceneValidator::check_robots(const chunk &c, std::vector<Diagnostic> &diagnostics) const {
+	std::vector<int> rows;
+	for (int i = c.begin; i < c.end; i++) {
+		const RobotSpec &r = (*_robots)[i];
+		Diagnostic d;
+		d.target = ROBOT;
+		d.row = i;
+
+		// ids
+		int first = (r.id >= 0) ? _first_row.value(r.id, i) : i;
+		if (first != i) {
+			d.check = DUPLICATE_ID;
+			d.value = r.id;
+			d.other = first;
+			diagnostics.push_back(d);
+		}
+
+		// form
+		if (r.form != rs::LINKBOTI && r.form != rs::LINKBOTL && r.form != rs::LINKBOTT && r.form != rs::MOBOT) {
+			d.check = UNKNOWN_FORM;
+			d.value = r.form;
+			d.other = -1;
+			diagnostics.push_back(d);
+		}
+		else if (r.form == rs::MOBOT) {
+			// valid in a scene file, but the scene builder has no mobot to draw
+			d.check = UNDRAWABLE_FORM;
+			d.severity = SEVERITY_WARNING;
+			d.value = r.form;
+			d.other = -1;
+			diagnostics.push_back(d);
+			d.severity = SEVERITY_ERROR;
+		}
+
+		// placement problems are reported but do not fail a scene
+		d.severity = SEVERITY_WARNING;
+		d.value = 0;
+
+		// other robots, each pair once at its later row
+		rows = _robot_index.overlapping(i);
+		std::sort(rows.begin(), rows.end());
+		for (unsigned int j = 0; j < rows.size() && rows[j] < i; j++) {
+			d.check = ROBOT_OVERLAP;
+			d.other = rows[j];
+			diagnostics.push_back(d);
+		}
+
+		// obstacles
+		double hx, hy;
+		robotModel::getFootprint(r, &hx, &hy);
+		rows = _obstacle_index.overlapping(r.p[0], r.p[1], hx, hy, r.r[2]*DEG2RAD);
+		std::sort(rows.begin(), rows.end());
+		for (unsigned int j = 0; j < rows.size(); j++) {
+			d.check = OBSTACLE_OVERLAP;
+			d.other = rows[j];
+			diagnostics.push_back(d);
+		}
+
+		// grid
+		if (!this->in_grid(r.p[0], r.p[1])) {
+			d.check = OUT_OF_GRID;
+			d.other = -1;
+			diagnostics.push_back(d);
+		}
+	}
+}
+
+bool sceneValidator::in_grid(double x, double y) const {
+	if (!_grid || _grid->size() < 7) return true;
+	const std::vector<double> &g = *_grid;
+	if (g[3] <= g[2] || g[5] <= g[4]) return true;
+	return (x >= g[2] && x <= g[3] && y >= g[4] && y <= g[5]);
+}
+
+/*!
+	Builds the lookup tables shared by all chunks: the first row of each
+	id and the footprints of robots and obstacles.
+*/
+void sceneValidator::prepare(void) {
+	_first_row.clear();
+	_robot_index.clear();
+	_obstacle_index.clear();
+
+	if (_robots) {
+		int n = _robots->size();
+		_first_row.reserve(n);
+		_robot_index.insertRows(0, n);
+		for (int i = 0; i < n; i++) {
+			const RobotSpec &r = (*_robots)[i];
+			if (r.id >= 0 && !_first_row.contains(r.id))
+				_first_row.insert(r.id, i);
+			double hx, hy;
+			robotModel::getFootprint(r, &hx, &hy);
+			_robot_index.update(i, r.p[0], r.p[1], hx, hy, r.r[2]*DEG2RAD);
+		}
+	}
+
+	if (_obstacles) {
+		int n = _obstacles->size();
+		_obstacle_index.insertRows(0, n);
+		for (int i = 0; i < n; i++) {
+			const ObstacleSpec &o = (*_obstacles)[i];
+			if (o.type != rs::BOX && o.type != rs::CYLINDER && o.type != rs::SPHERE) continue;
+			double hx, hy;
+			sceneValidator::obstacle_footprint(o, &hx, &hy);
+			_obstacle_index.update(i, o.p[0], o.p[1], hx, hy, o.r[2]*DEG2RAD);
+		}
+	}
+}
+
+/*!
+	Fills the half extents of an obstacle on the ground. Cylinders and
+	spheres are bounded by their radius.
+*/
+void sceneValidator::obstacle_footprint(const ObstacleSpec &o, double *hx, double *hy) {
+	if (o.type == rs::BOX) {
+		*hx = o.l[0]/2;
+		*hy = o.l[1]/2;
+	}
+	else {
+		*hx = o.l[0];
+		*hy = o.l[0];
+	}
+}
@@ -0,0 +1,186 @@
+#include <iostream>
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+
+#include "binaryscene.h"
+#include "scenefile.h"
+#include "scenewatcher.h"
+#include "xmlreader.h"
+
+using namespace rsModel;
+
+sceneWatcher::sceneWatcher(robotModel *model, const QString &fileName, QObject *parent) : QObject(parent) {
+	_model = model;
+	_file_name = fileName;
+	_enabled = false;
+	_saved_size = -1;
+	_saved_mtime = -1;
+
+	// scripts often write a file in several steps, so wait for them to settle
+	_timer.setSingleShot(true);
+	_timer.setInterval(200);
+	QObject::connect(&_timer, SIGNAL(timeout()), this, SLOT(reload()));
+	QObject::connect(&_watcher, SIGNAL(fileChanged(const QString&)), this, SLOT(fileChanged(const QString&)));
+}
+
+bool sceneWatcher::isEnabled(void) const {
+	return _enabled;
+}
+
+/*!
+	Remembers the file as this program just wrote it, so the change
+	notification of its own save does not reload it.
+*/
+void sceneWatcher::markSaved(void) {
+	this->file_identity(&_saved_size, &_saved_mtime);
+}
+
+/*!
+	Reads the file again and applies the difference to the model. Returns
+	true if the model changed; reloaded() is only emitted then. A file
+	that could not be read leaves the model as it was.
+*/
+bool sceneWatcher::reload(void) {
+	// skip the file as written by our own save
+	qint64 size, mtime;
+	this->file_identity(&size, &mtime);
+	if (size == _saved_size && mtime == _saved_mtime)
+		return false;
+
+	std::vector<RobotSpec> specs;
+	if (!this->read_robots(specs)) {
+		std::cerr << "Warning: Cannot reload " << qPrintable(_file_name) << std::endl;
+		return false;
+	}
+	if (!this->apply(specs))
+		return false;
+	emit reloaded(_file_name);
+	return true;
+}
+
+void sceneWatcher::setEnabled(bool enabled) {
+	_enabled = enabled;
+	if (_enabled && !_watcher.files().contains(_file_name))
+		_watcher.addPath(_file_name);
+	else if (!_enabled && !_watcher.files().isEmpty())
+		_watcher.removePaths(_watcher.files());
+	if (!_enabled) _timer.stop();
+}
+
+void sceneWatcher::fileChanged(const QString&) {
+	if (!_enabled) return;
+
+	// files replaced by a rename drop out of the watcher
+	if (!_watcher.files().contains(_file_name) && QFile::exists(_file_name))
+		_watcher.addPath(_file_name);
+	_timer.start();
+}
+
+/*!
+	Applies the robots read from the file to the model in three steps:
+	robots whose id is gone are removed, robots whose fields differ are
+	updated in a single model update, and new ids are added in one
+	batch. Robots without an id are matched by their place in the file.
+	Returns true if the model changed.
+*/
+bool sceneWatcher::apply(const std::vector<RobotSpec> &specs) {
+	int rows = _model->rowCount();
+	std::vector<int> match(specs.size(), -1);		// row of each spec
+	std::vector<bool> keep(rows, false);
+
+	// match by id
+	for (unsigned int i = 0; i < specs.size(); i++) {
+		if (specs[i].id < 0) continue;
+		int row = _model->rowForId(specs[i].id);
+		if (row >= 0 && !keep[row] && _model->getInt(row, ID) == specs[i].id) {
+			match[i] = row;
+			keep[row] = true;
+		}
+	}
+
+	// match robots without id by position
+	for (unsigned int i = 0; i < specs.size(); i++) {
+		if (specs[i].id < 0 && static_cast<int>(i) < rows && !keep[i]) {
+			match[i] = i;
+			keep[i] = true;
+		}
+	}
+
+	// robots whose form or preconfig changed are replaced
+	for (unsigned int i = 0; i < specs.size(); i++) {
+		int row = match[i];
+		if (row >= 0 && (_model->getInt(row, FORM) != specs[i].form || _model->getInt(row, PRECONFIG) != specs[i].preconfig)) {
+			keep[row] = false;
+			match[i] = -1;
+		}
+	}
+
+	bool changed = false;
+	robotModelUpdate update(_model);
+
+	// update fields of matched robots
+	for (unsigned int i = 0; i < specs.size(); i++) {
+		int row = match[i];
+		if (row < 0) continue;
+		const RobotSpec &s = specs[i];
+		double p[3], r[3];
+		_model->getPosition(row, p);
+		_model->getRotation(row, r);
+		for (int j = 0; j < 3; j++) {
+			if (p[j] != s.p[j]) changed |= _model->setDouble(row, P_X + j, s.p[j]);
+			if (r[j] != s.r[j]) changed |= _model->setDouble(row, R_PHI + j, s.r[j]);
+		}
+		if (_model->getDouble(row, RADIUS) != s.radius) changed |= _model->setDouble(row, RADIUS, s.radius);
+		if (_model->getInt(row, WHEEL) != s.wheel) changed |= _model->setInt(row, WHEEL, s.wheel);
+	}
+
+	// remove unmatched rows in runs, from the end so rows stay valid
+	for (int row = rows - 1; row >= 0; row--) {
+		if (keep[row]) continue;
+		int last = row;
+		while (row > 0 && !keep[row - 1]) row--;
+		_model->removeRows(row, last - row + 1);
+		changed = true;
+	}
+
+	// add new robots in one batch
+	std::vector<RobotSpec> added;
+	for (unsigned int i = 0; i < specs.size(); i++) {
+		if (match[i] < 0) added.push_back(specs[i]);
+	}
+	if (!added.empty()) {
+		_model->addRobots(added);
+		changed = true;
+	}
+
+	return changed;
+}
+
+/*!
+	Returns the size and modification time of the file, or -1 if it does
+	not exist.
+*/
+void sceneWatcher::file_identity(qint64 *size, qint64 *mtime) const {
+	QFileInfo info(_file_name);
+	*size = (info.exists()) ? info.size() : -1;
+	*mtime = (info.exists()) ? info.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+/*!
+	Reads the robots of the file without touching the model.
+*/
+bool sceneWatcher::read_robots(std::vector<RobotSpec> &specs) {
+	if (sceneFile::format(_file_name) == BINARY) {
+		binaryScene scene;
+		if (!scene.read(_file_name)) return false;
+		specs = scene.getRobots();
+		return true;
+	}
+
+	xmlReader reader;
+	if (!reader.read(_file_name)) return false;
+	specs = reader.getRobots();
+	return true;
+}
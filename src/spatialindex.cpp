@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "spatialindex.h"
+
+namespace {
+	// collects rows whose footprint intersects a query footprint
+	template<class F> struct overlapVisitor {
+		overlapVisitor(const F &query, int skip) : query(query), skip(skip) {}
+		const F &query;
+		int skip;
+		std::vector<int> rows;
+	};
+
+	struct candidate {
+		double d;
+		int i, j;
+		bool operator<(const candidate &c) const { return d < c.d; }
+	};
+}
+
+/*!
+	Creates a uniform grid hash over robot footprints. Each footprint is
+	an oriented rectangle on the ground plane, stored in the cell holding
+	its center, so maintenance is O(1) per robot and queries only visit
+	cells near the query region.
+*/
+spatialIndex::spatialIndex(double cell) {
+	_cell = cell;
+}
+
+void spatialIndex::clear(void) {
+	_rows.clear();
+	_cells.clear();
+	_extents.clear();
+}
+
+/*!
+	Adds count empty rows at row. Appending is O(1); inserting in the
+	middle renumbers the following rows.
+*/
+void spatialIndex::insertRows(int row, int count) {
+	bool append = (row == static_cast<int>(_rows.size()));
+	_rows.insert(_rows.begin() + row, count, footprint());
+	if (!append) this->rebuild();
+}
+
+/*!
+	Removes count rows at row. Removing from the end is O(count);
+	removing from the middle renumbers the following rows.
+*/
+void spatialIndex::removeRows(int row, int count) {
+	bool tail = (row + count == static_cast<int>(_rows.size()));
+	for (int i = row; i < row + count; i++) {
+		if (!_rows[i].valid) continue;
+		_extents.erase(_extents.find(_rows[i].extent));
+		if (tail) this->cell_remove(i);
+	}
+	_rows.erase(_rows.begin() + row, _rows.begin() + row + count);
+	if (!tail) this->rebuild();
+}
+
+/*!
+	Sets the footprint of a row: center, half extents and rotation about
+	the z axis in radians.
+*/
+void spatialIndex::update(int row, double x, double y, double hx, double hy, double angle) {
+	footprint &f = _rows[row];
+	if (f.valid) {
+		this->cell_remove(row);
+		_extents.erase(_extents.find(f.extent));
+	}
+	f.x = x;
+	f.y = y;
+	f.hx = hx;
+	f.hy = hy;
+	f.angle = angle;
+	f.extent = sqrt(hx*hx + hy*hy);
+	f.valid = true;
+	_extents.insert(f.extent);
+	this->cell_insert(row);
+}
+
+/*!
+	Returns the row whose footprint contains the point, preferring the
+	closest center, or -1.
+*/
+int spatialIndex::at(double x, double y) const {
+	std::vector<int> rows = this->overlapping(x, y, 0, 0, 0);
+	int best = -1;
+	double d = 0;
+	for (unsigned int i = 0; i < rows.size(); i++) {
+		const footprint &f = _rows[rows[i]];
+		double di = (f.x - x)*(f.x - x) + (f.y - y)*(f.y - y);
+		if (best == -1 || di < d) {
+			best = rows[i];
+			d = di;
+		}
+	}
+	return best;
+}
+
+/*!
+	Finds the free slot closest to (x, y) for a footprint of the given
+	size, searching lattice points spaced one footprint apart in growing
+	rings around (x, y). Returns false if no slot is found.
+*/
+bool spatialIndex::nearestFree(double x, double y, double hx, double hy, double angle, double *fx, double *fy) const {
+	double step = std::max(2*std::max(hx, hy), 0.01);
+	std::vector<candidate> ring;
+	for (int k = 0; k < 1000; k++) {
+		// lattice points on ring k, nearest first
+		ring.clear();
+		for (int i = -k; i <= k; i++) {
+			for (int j = -k; j <= k; j++) {
+				if (std::max(abs(i), abs(j)) != k) continue;
+				candidate c;
+				c.i = i;
+				c.j = j;
+				c.d = i*i + j*j;
+				ring.push_back(c);
+			}
+		}
+		std::sort(ring.begin(), ring.end());
+
+		for (unsigned int n = 0; n < ring.size(); n++) {
+			double cx = x + ring[n].i*step;
+			double cy = y + ring[n].j*step;
+			if (this->overlapping(cx, cy, hx, hy, angle).empty()) {
+				*fx = cx;
+				*fy = cy;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/*!
+	Returns the rows overlapping the footprint of row.
+*/
+std::vector<int> spatialIndex::overlapping(int row) const {
+	const footprint &f = _rows[row];
+	if (!f.valid) return std::vector<int>();
+	return this->overlapping(f.x, f.y, f.hx, f.hy, f.angle, row);
+}
+
+/*!
+	Returns the rows overlapping a footprint, leaving out skip.
+*/
+std::vector<int> spatialIndex::overlapping(double x, double y, double hx, double hy, double angle, int skip) const {
+	footprint query;
+	query.x = x;
+	query.y = y;
+	query.hx = hx;
+	query.hy = hy;
+	query.angle = angle;
+	query.valid = true;
+
+	overlapVisitor<footprint> visitor(query, skip);
+	double r = sqrt(hx*hx + hy*hy);
+	this->visit(x - r, y - r, x + r, y + r, visitor);
+	return visitor.rows;
+}
+
+/*!
+	Returns the rows whose centers lie in the rectangle.
+*/
+std::vector<int> spatialIndex::inRegion(double minx, double miny, double maxx, double maxy) const {
+	std::vector<int> rows;
+	qint64 nx = static_cast<qint64>(floor(maxx/_cell) - floor(minx/_cell)) + 1;
+	qint64 ny = static_cast<qint64>(floor(maxy/_cell) - floor(miny/_cell)) + 1;
+
+	// large regions are cheaper to scan directly
+	if (nx*ny > static_cast<qint64>(_rows.size())) {
+		for (unsigned int i = 0; i < _rows.size(); i++) {
+			const footprint &f = _rows[i];
+			if (f.valid && f.x >= minx && f.x <= maxx && f.y >= miny && f.y <= maxy)
+				rows.push_back(i);
+		}
+		return rows;
+	}
+
+	for (qint64 i = 0; i < nx; i++) {
+		for (qint64 j = 0; j < ny; j++) {
+			QHash<quint64, std::vector<int> >::const_iterator c = _cells.constFind(this->cell(minx + i*_cell, miny + j*_cell));
+			if (c == _cells.constEnd()) continue;
+			for (unsigned int n = 0; n < c.value().size(); n++) {
+				const footprint &f = _rows[c.value()[n]];
+				if (f.x >= minx && f.x <= maxx && f.y >= miny && f.y <= maxy)
+					rows.push_back(c.value()[n]);
+			}
+		}
+	}
+	return rows;
+}
+
+int spatialIndex::size(void) const {
+	return _rows.size();
+}
+
+quint64 spatialIndex::cell(double x, double y) const {
+	return spatialIndex::cell_key(static_cast<qint64>(floor(x/_cell)), static_cast<qint64>(floor(y/_cell)));
+}
+
+/*!
+	Packs the column and row of a cell into a hash key. Both are taken
+	as unsigned, since shifting a negative column is undefined.
+*/
+quint64 spatialIndex::cell_key(qint64 i, qint64 j) {
+	return (static_cast<quint64>(i) << 32) ^ static_cast<quint32>(j);
+}
+
+void spatialIndex::cell_insert(int row) {
+	_cells[this->cell(_rows[row].x, _rows[row].y)].push_back(row);
+}
+
+void spatialIndex::cell_remove(int row) {
+	if (!_rows[row].valid) return;
+	QHash<quint64, std::vector<int> >::iterator c = _cells.find(this->cell(_rows[row].x, _rows[row].y));
+	if (c == _cells.end()) return;
+	std::vector<int> &rows = c.value();
+	std::vector<int>::iterator i = std::find(rows.begin(), rows.end(), row);
+	if (i != rows.end()) {
+		*i = rows.back();
+		rows.pop_back();
+	}
+	if (rows.empty()) _cells.erase(c);
+}
+
+/*!
+	Separating axis test between two oriented rectangles.
+*/
+bool spatialIndex::intersects(const footprint &a, const footprint &b) const {
+	double axes[4][2] = {
+		{cos(a.angle), sin(a.angle)}, {-sin(a.angle), cos(a.angle)},
+		{cos(b.angle), sin(b.angle)}, {-sin(b.angle), cos(b.angle)}
+	};
+	double dx = b.x - a.x;
+	double dy = b.y - a.y;
+	for (int i = 0; i < 4; i++) {
+		double u[2] = {axes[i][0], axes[i][1]};
+		double ra = a.hx*fabs(axes[0][0]*u[0] + axes[0][1]*u[1]) + a.hy*fabs(axes[1][0]*u[0] + axes[1][1]*u[1]);
+		double rb = b.hx*fabs(axes[2][0]*u[0] + axes[2][1]*u[1]) + b.hy*fabs(axes[3][0]*u[0] + axes[3][1]*u[1]);
+		double d = fabs(dx*u[0] + dy*u[1]);
+		if (d > ra + rb || (d == ra + rb && d > 0))		// touching is not overlapping
+			return false;
+	}
+	return true;
+}
+
+/*!
+	Returns the largest distance from a stored center to a corner of its
+	footprint, the margin a query needs to find every overlapping row.
+*/
+double spatialIndex::max_extent(void) const {
+	return (_extents.empty()) ? 0 : *_extents.rbegin();
+}
+
+void spatialIndex::rebuild(void) {
+	_cells.clear();
+	for (unsigned int i = 0; i < _rows.size(); i++) {
+		if (_rows[i].valid) this->cell_insert(i);
+	}
+}
+
+/*!
+	Calls visitor for every row overlapping the query held by visitor,
+	looking only at cells that can hold such rows.
+*/
+template<class T> void spatialIndex::visit(double minx, double miny, double maxx, double maxy, T &visitor) const {
+	double extent = this->max_extent();
+	minx -= extent;
+	miny -= extent;
+	maxx += extent;
+	maxy += extent;
+	qint64 x0 = static_cast<qint64>(floor(minx/_cell));
+	qint64 y0 = static_cast<qint64>(floor(miny/_cell));
+	qint64 x1 = static_cast<qint64>(floor(maxx/_cell));
+	qint64 y1 = static_cast<qint64>(floor(maxy/_cell));
+
+	for (qint64 i = x0; i <= x1; i++) {
+		for (qint64 j = y0; j <= y1; j++) {
+			QHash<quint64, std::vector<int> >::const_iterator c = _cells.constFind(spatialIndex::cell_key(i, j));
+			if (c == _cells.constEnd()) continue;
+			for (unsigned int n = 0; n < c.value().size(); n++) {
+				int row = c.value()[n];
+				if (row != visitor.skip && this->intersects(_rows[row], visitor.query))
+					visitor.rows.push_back(row);
+			}
+		}
+	}
+}
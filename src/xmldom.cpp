@@ -34,7 +34,18 @@ int xmlDom::parseSim(QStandardItemModel *model) {
 		if	(	child.tagName() == "linkboti" ||
 				child.tagName() == "linkbotl" ||
 				child.tagName() == "linkbott" ||
-				child.tagName() == "mobot"
+				child.tagName() == "mobot" ||
+				child.tagName() == "bow" ||
+				child.tagName() == "explorer" ||
+				child.tagName() == "fourbotdrive" ||
+				child.tagName() == "fourwheeldrive" ||
+				child.tagName() == "fourwheelexplorer" ||
+				child.tagName() == "groupbow" ||
+				child.tagName() == "inchworm" ||
+				child.tagName() == "lift" ||
+				child.tagName() == "omnidrive" ||
+				child.tagName() == "snake" ||
+				child.tagName() == "stand"
 			)
 			this->parse_robot(child);
 		child = child.nextSibling().toElement();
@@ -1,7 +1,15 @@
 #include "xmlreader.h"
 
-xmlReader::xmlReader(QTableWidget *table) {
-	_table = table;
+/*!
+	Creates a reader that streams a robosimrc file in one pass. When
+	models are given, the robots and obstacles read from the file replace
+	their contents with a single batched insert or reset each.
+*/
+xmlReader::xmlReader(robotModel *model, obstacleModel *obstacles) {
+	_model = model;
+	_obstacle_model = obstacles;
+	_tracking = false;
+	_version = 0;
 }
 
 bool xmlReader::read(const QString &fileName) {
@@ -12,11 +20,27 @@ bool xmlReader::read(const QString &fileName) {
 				  << std::endl;
 		return false;
 	}
-	_reader.setDevice(&file);
-	_reader.readNext();
-	while (!_reader.atEnd()) {
-		if (_reader.isStartElement()) {
-			std::cerr << "Value: " << qPrintable(_reader.name().toString()) << std::endl;
+	bool ok = this->read(&file);
+	file.close();
+	if (!ok) {
+		std::cerr << "Error: Failed to parse file "
+				  << qPrintable(fileName) << ": "
+				  << qPrintable(_reader.errorString()) << std::endl;
+	}
+	return ok;
+}
+
+bool xmlReader::read(QIODevice *device) {
+	// reset parsed data
+	_grid.clear();
+	_obstacles.clear();
+	_robots.clear();
+	_unknown.clear();
+
+	// parse each top-level section once
+	_reader.setDevice(device);
+	if (_reader.readNextStartElement()) {
+		while (_reader.readNextStartElement()) {
 			if (_reader.name() == "config")
 				read_config_element();
 			else if (_reader.name() == "graphics")
@@ -25,147 +49,200 @@ bool xmlReader::read(const QString &fileName) {
 				read_ground_element();
 			else if (_reader.name() == "sim")
 				read_sim_element();
-			else {
-				std::cerr << "error: " << std::endl;
-				_reader.readNext();
-				//_reader.raiseError(QObject::tr("Not a bookindex file"));
-			}
-		}
-		else {
-			_reader.readNext();
+			else
+				_reader.skipCurrentElement();
 		}
 	}
-	file.close();
-	if (_reader.hasError()) {
-		std::cerr << "Error: Failed to parse file "
-				  << qPrintable(fileName) << ": "
-				  << qPrintable(_reader.errorString()) << std::endl;
-		return false;
-	} else if (file.error() != QFile::NoError) {
-		std::cerr << "Error: Cannot read file " << qPrintable(fileName)
-				  << ": " << qPrintable(file.errorString())
-				  << std::endl;
+	if (_reader.hasError())
 		return false;
+
+	// replace model contents with one insert
+	if (_model) {
+		if (_model->rowCount())
+			_model->removeRows(0, _model->rowCount());
+		if (!_robots.empty())
+			_model->addRobots(_robots);
 	}
+	if (_obstacle_model)
+		_obstacle_model->setObstacles(_obstacles);
+
 	return true;
 }
 
-int xmlReader::getVersion(void) {
-	return _version;
+QString xmlReader::errorString(void) {
+	return _reader.errorString();
 }
 
-void xmlReader::read_config_element(void) {
-	std::cerr << "entering config element" << std::endl;
-	while (!_reader.atEnd()) {
-		_reader.readNextStartElement();
-		if (_reader.isEndElement()) {
-			_reader.readNextStartElement();
-			break;
-		}
+/*!
+	Returns the grid as tics, hash, min x, max x, min y, max y and
+	enabled, in the units of the file. Empty if the file has no grid.
+*/
+std::vector<double> xmlReader::getGrid(void) {
+	return _grid;
+}
 
-		if (_reader.isStartElement()) {
-			if (_reader.name() == "version")
-                _version = 0;//_reader.attributes().value("val").toInt();
-			else
-				_reader.readNextStartElement();
+const std::vector<rsModel::ObstacleSpec>& xmlReader::getObstacles(void) {
+	return _obstacles;
+}
 
-			_reader.readNextStartElement();
-		}
-		else {
-			_reader.readNextStartElement();
-		}
-	}
-	//std::cerr << "version: " << _version << std::endl;
-	std::cerr << "leaving config element" << std::endl;
+const std::vector<rsModel::RobotSpec>& xmlReader::getRobots(void) {
+	return _robots;
+}
 
-	return;
+/*!
+	Returns the elements of the ground and sim sections that are not a
+	known obstacle or robot, with the line they start on.
+*/
+const std::vector<rsModel::UnknownElement>& xmlReader::getUnknown(void) {
+	return _unknown;
 }
 
-void xmlReader::read_graphics_element(void) {
-	std::cerr << "entering graphics element" << std::endl;
-	while (!_reader.atEnd()) {
-		_reader.readNextStartElement();
-		if (_reader.isEndElement()) {
-			_reader.readNextStartElement();
-			break;
-		}
+bool xmlReader::getTracking(void) {
+	return _tracking;
+}
 
-		if (_reader.isStartElement()) {
-			if (_reader.name() == "grid") {
-				//_grid[0] = _reader.attributes().value("minx").toDouble();
-				//_grid[1] = _reader.attributes().value("maxx").toDouble();
-				//_grid[2] = _reader.attributes().value("miny").toDouble();
-				//_grid[3] = _reader.attributes().value("maxy").toDouble();
-				int a = 9;
-			}
-			if (_reader.name() == "tracking") {
-				//_tracked = _reader.attributes().value("val").toInt();
-				int b = 3;
-			}
-			else
-				_reader.readNextStartElement();
+int xmlReader::getVersion(void) {
+	return _version;
+}
 
-			_reader.readNextStartElement();
-		}
-		else {
-			_reader.readNextStartElement();
-		}
+void xmlReader::read_config_element(void) {
+	while (_reader.readNextStartElement()) {
+		if (_reader.name() == "version")
+			_version = static_cast<int>(this->attribute(_reader.attributes(), "val"));
+		_reader.skipCurrentElement();
 	}
-	//std::cerr << "version: " << _version << std::endl;
-	std::cerr << "leaving config element" << std::endl;
+}
 
-	return;
+void xmlReader::read_graphics_element(void) {
+	while (_reader.readNextStartElement()) {
+		QXmlStreamAttributes attr = _reader.attributes();
+		if (_reader.name() == "grid") {
+			_grid.clear();
+			_grid.push_back(this->attribute(attr, "tics"));
+			_grid.push_back(this->attribute(attr, "major"));
+			_grid.push_back(this->attribute(attr, "minx"));
+			_grid.push_back(this->attribute(attr, "maxx"));
+			_grid.push_back(this->attribute(attr, "miny"));
+			_grid.push_back(this->attribute(attr, "maxy"));
+			_grid.push_back(this->attribute(attr, "enabled", 1));
+		}
+		else if (_reader.name() == "tracking")
+			_tracking = static_cast<int>(this->attribute(attr, "val"));
+		_reader.skipCurrentElement();
+	}
 }
 
 void xmlReader::read_ground_element(void) {
-	std::cerr << "entering ground element" << std::endl;
+	while (_reader.readNextStartElement()) {
+		if (_reader.name() == "box")
+			read_obstacle_element(rs::BOX);
+		else if (_reader.name() == "cylinder")
+			read_obstacle_element(rs::CYLINDER);
+		else if (_reader.name() == "sphere")
+			read_obstacle_element(rs::SPHERE);
+		else
+			skip_unknown_element();
+	}
 }
 
 void xmlReader::read_sim_element(void) {
-	std::cerr << "entering sim element" << std::endl;
+	while (_reader.readNextStartElement()) {
+		QStringRef name = _reader.name();
+		if (name == "linkboti")					read_robot_element(rs::LINKBOTI, 0);
+		else if (name == "linkbotl")			read_robot_element(rs::LINKBOTL, 0);
+		else if (name == "linkbott")			read_robot_element(rs::LINKBOTT, 0);
+		else if (name == "mobot")				read_robot_element(rs::MOBOT, 0);
+		else if (name == "bow")					read_robot_element(rs::LINKBOTI, rsLinkbot::BOW);
+		else if (name == "explorer")			read_robot_element(rs::LINKBOTI, rsLinkbot::EXPLORER);
+		else if (name == "fourbotdrive")		read_robot_element(rs::LINKBOTI, rsLinkbot::FOURBOTDRIVE);
+		else if (name == "fourwheeldrive")		read_robot_element(rs::LINKBOTI, rsLinkbot::FOURWHEELDRIVE);
+		else if (name == "fourwheelexplorer")	read_robot_element(rs::LINKBOTI, rsLinkbot::FOURWHEELEXPLORER);
+		else if (name == "groupbow")			read_robot_element(rs::LINKBOTI, rsLinkbot::GROUPBOW);
+		else if (name == "inchworm")			read_robot_element(rs::LINKBOTI, rsLinkbot::INCHWORM);
+		else if (name == "lift")				read_robot_element(rs::LINKBOTI, rsLinkbot::LIFT);
+		else if (name == "omnidrive")			read_robot_element(rs::LINKBOTI, rsLinkbot::OMNIDRIVE);
+		else if (name == "snake")				read_robot_element(rs::LINKBOTI, rsLinkbot::SNAKE);
+		else if (name == "stand")				read_robot_element(rs::LINKBOTI, rsLinkbot::STAND);
+		else
+			skip_unknown_element();
+	}
 }
 
-void xmlReader::readEntryElement(QTableWidgetItem *parent) {
-	QTableWidgetItem *item = new QTableWidgetItem();
-
-	_reader.readNext();
-	while (!_reader.atEnd()) {
-		if (_reader.isEndElement()) {
-			_reader.readNext();
-			break;
+void xmlReader::read_obstacle_element(int type) {
+	rsModel::ObstacleSpec spec;
+	spec.type = type;
+	spec.mass = this->attribute(_reader.attributes(), "mass");
+
+	while (_reader.readNextStartElement()) {
+		QXmlStreamAttributes attr = _reader.attributes();
+		if (_reader.name() == "position") {
+			spec.p[0] = this->attribute(attr, "x");
+			spec.p[1] = this->attribute(attr, "y");
+			spec.p[2] = this->attribute(attr, "z");
 		}
-
-		if (_reader.isStartElement()) {
-			if (_reader.name() == "entry")
-				readEntryElement(item);
-			else if (_reader.name() == "page")
-				readPageElement(item);
-			else
-				skip_unknown_element();
+		else if (_reader.name() == "rotation") {
+			spec.r[0] = this->attribute(attr, "phi");
+			spec.r[1] = this->attribute(attr, "theta");
+			spec.r[2] = this->attribute(attr, "psi");
 		}
-		else {
-			_reader.readNext();
+		else if (_reader.name() == "size") {
+			if (type == rs::BOX) {
+				spec.l[0] = this->attribute(attr, "x");
+				spec.l[1] = this->attribute(attr, "y");
+				spec.l[2] = this->attribute(attr, "z");
+			}
+			else {
+				spec.l[0] = this->attribute(attr, "radius");
+				spec.l[1] = this->attribute(attr, "length");
+			}
+		}
+		else if (_reader.name() == "color") {
+			spec.c[0] = this->attribute(attr, "r");
+			spec.c[1] = this->attribute(attr, "g");
+			spec.c[2] = this->attribute(attr, "b");
+			spec.c[3] = this->attribute(attr, "alpha", 1);
 		}
+		_reader.skipCurrentElement();
 	}
+	_obstacles.push_back(spec);
+}
 
-	return;
+void xmlReader::read_robot_element(int form, int preconfig) {
+	rsModel::RobotSpec spec;
+	spec.form = form;
+	spec.preconfig = preconfig;
+	spec.id = static_cast<int>(this->attribute(_reader.attributes(), "id", -1));
+
+	while (_reader.readNextStartElement()) {
+		QXmlStreamAttributes attr = _reader.attributes();
+		if (_reader.name() == "position") {
+			spec.p[0] = this->attribute(attr, "x");
+			spec.p[1] = this->attribute(attr, "y");
+			spec.p[2] = this->attribute(attr, "z");
+		}
+		else if (_reader.name() == "rotation") {
+			spec.r[0] = this->attribute(attr, "phi");
+			spec.r[1] = this->attribute(attr, "theta");
+			spec.r[2] = this->attribute(attr, "psi");
+		}
+		else if (_reader.name() == "wheels") {
+			spec.wheel = static_cast<int>(this->attribute(attr, "val"));
+			spec.radius = this->attribute(attr, "radius");
+		}
+		_reader.skipCurrentElement();
+	}
+	_robots.push_back(spec);
 }
 
-void xmlReader::readPageElement(QTableWidgetItem *parent) {
+double xmlReader::attribute(const QXmlStreamAttributes &attr, const char *name, double value) {
+	QStringRef s = attr.value(name);
+	return (s.isEmpty()) ? value : s.toString().toDouble();
 }
 
 void xmlReader::skip_unknown_element(void) {
-	_reader.readNext();
-	while (!_reader.atEnd()) {
-		if (_reader.isEndElement()) {
-			_reader.readNext();
-			break;
-		}
-
-		if (_reader.isStartElement()) {
-			skip_unknown_element();
-		} else {
-			_reader.readNext();
-		}
-	}
+	rsModel::UnknownElement element;
+	element.name = _reader.name().toString();
+	element.line = _reader.lineNumber();
+	_unknown.push_back(element);
+	_reader.skipCurrentElement();
 }
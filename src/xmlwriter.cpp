@@ -0,0 +1,279 @@
+#include "savefile.h"
+#include "xmlwriter.h"
+
+using namespace rsModel;
+
+/*!
+	Creates a writer that serializes the model as a robosimrc file, one
+	row at a time. With a source file, sections whose settings were not
+	given are streamed unchanged from the source, together with any
+	sections this writer does not know.
+*/
+xmlWriter::xmlWriter(robotModel *model) {
+	_model = model;
+	_set = 0;
+	_tracking = false;
+	_version = 0;
+}
+
+/*!
+	Writes the scene to a temporary file that replaces fileName once it
+	is complete.
+*/
+bool xmlWriter::write(const QString &fileName) {
+	saveFile file(fileName);
+	if (!file.open(QFile::WriteOnly | QFile::Text)) {
+		std::cerr << "Error: Cannot write file " << qPrintable(fileName)
+				  << ": " << qPrintable(file.errorString())
+				  << std::endl;
+		return false;
+	}
+	bool ok = this->write(&file) && file.commit();
+	if (!ok) {
+		std::cerr << "Error: Cannot write file " << qPrintable(fileName)
+				  << ": " << qPrintable(file.errorString())
+				  << std::endl;
+	}
+	return ok;
+}
+
+bool xmlWriter::write(QIODevice *device) {
+	_writer.setDevice(device);
+	_writer.setAutoFormatting(true);
+	_writer.writeStartDocument();
+	_writer.writeStartElement("robosim");
+
+	// walk sections of the source in order, copying the unchanged ones
+	int written = 0;
+	QFile source(_source);
+	if (!_source.isEmpty() && source.open(QFile::ReadOnly | QFile::Text)) {
+		QXmlStreamReader reader(&source);
+		if (reader.readNextStartElement() && reader.name() == "robosim") {
+			while (reader.readNextStartElement()) {
+				int flag = this->section_flag(reader.name());
+				if (flag & written) {
+					reader.skipCurrentElement();
+				}
+				else if (flag && (flag == SIM || (_set & flag))) {
+					this->write_section(flag);
+					written |= flag;
+					reader.skipCurrentElement();
+				}
+				else {
+					this->copy_element(reader);
+					written |= flag;
+				}
+			}
+		}
+		if (reader.hasError()) {
+			std::cerr << "Warning: Cannot copy from " << qPrintable(_source)
+					  << ": " << qPrintable(reader.errorString()) << std::endl;
+		}
+	}
+
+	// write sections missing from the source
+	for (int flag = CONFIG; flag <= SIM; flag <<= 1) {
+		if (!(written & flag))
+			this->write_section(flag);
+	}
+
+	_writer.writeEndElement();
+	_writer.writeEndDocument();
+
+	return !_writer.hasError();
+}
+
+void xmlWriter::setGrid(const std::vector<double> &grid) {
+	_grid = grid;
+	_set |= GRAPHICS;
+}
+
+void xmlWriter::setObstacles(const std::vector<ObstacleSpec> &obstacles) {
+	_obstacles = obstacles;
+	_set |= GROUND;
+}
+
+/*!
+	Sets the robosimrc file to take unchanged sections from. The source
+	may be the file being written, as long as the output goes to another
+	file first.
+*/
+void xmlWriter::setSource(const QString &fileName) {
+	_source = fileName;
+}
+
+void xmlWriter::setTracking(bool tracking) {
+	_tracking = tracking;
+	_set |= GRAPHICS;
+}
+
+void xmlWriter::setVersion(int version) {
+	_version = version;
+	_set |= CONFIG;
+}
+
+/*!
+	Returns the sim element name for a robot form and preconfig, the
+	inverse of xmlReader's mapping.
+*/
+QString xmlWriter::robotTag(int form, int preconfig) {
+	switch (preconfig) {
+		case rsLinkbot::BOW:				return "bow";
+		case rsLinkbot::EXPLORER:			return "explorer";
+		case rsLinkbot::FOURBOTDRIVE:		return "fourbotdrive";
+		case rsLinkbot::FOURWHEELDRIVE:		return "fourwheeldrive";
+		case rsLinkbot::FOURWHEELEXPLORER:	return "fourwheelexplorer";
+		case rsLinkbot::GROUPBOW:			return "groupbow";
+		case rsLinkbot::INCHWORM:			return "inchworm";
+		case rsLinkbot::LIFT:				return "lift";
+		case rsLinkbot::OMNIDRIVE:			return "omnidrive";
+		case rsLinkbot::SNAKE:				return "snake";
+		case rsLinkbot::STAND:				return "stand";
+		default:							break;
+	}
+	switch (form) {
+		case rs::LINKBOTI:	return "linkboti";
+		case rs::LINKBOTL:	return "linkbotl";
+		case rs::LINKBOTT:	return "linkbott";
+		case rs::MOBOT:		return "mobot";
+		default:			return QString();
+	}
+}
+
+/*!
+	Copies the element at the reader's position to the output token by
+	token. Whitespace is left to the writer's own formatting.
+*/
+void xmlWriter::copy_element(QXmlStreamReader &reader) {
+	int depth = 0;
+	do {
+		if (reader.isStartElement())
+			depth++;
+		else if (reader.isEndElement())
+			depth--;
+		if (!reader.isWhitespace())
+			_writer.writeCurrentToken(reader);
+	} while (depth > 0 && !reader.atEnd() && reader.readNext() != QXmlStreamReader::Invalid);
+}
+
+int xmlWriter::section_flag(const QStringRef &name) const {
+	if (name == "config") return CONFIG;
+	else if (name == "graphics") return GRAPHICS;
+	else if (name == "ground") return GROUND;
+	else if (name == "sim") return SIM;
+	return 0;
+}
+
+void xmlWriter::write_section(int flag) {
+	switch (flag) {
+		case CONFIG:	this->write_config_element(); break;
+		case GRAPHICS:	this->write_graphics_element(); break;
+		case GROUND:	this->write_ground_element(); break;
+		case SIM:		this->write_sim_element(); break;
+		default:		break;
+	}
+}
+
+void xmlWriter::write_config_element(void) {
+	_writer.writeStartElement("config");
+	_writer.writeEmptyElement("version");
+	_writer.writeAttribute("val", QString::number(_version));
+	_writer.writeEndElement();
+}
+
+void xmlWriter::write_graphics_element(void) {
+	_writer.writeStartElement("graphics");
+	if (_grid.size() >= 7) {
+		_writer.writeEmptyElement("grid");
+		_writer.writeAttribute("tics", xmlWriter::number(_grid[0]));
+		_writer.writeAttribute("major", xmlWriter::number(_grid[1]));
+		_writer.writeAttribute("minx", xmlWriter::number(_grid[2]));
+		_writer.writeAttribute("maxx", xmlWriter::number(_grid[3]));
+		_writer.writeAttribute("miny", xmlWriter::number(_grid[4]));
+		_writer.writeAttribute("maxy", xmlWriter::number(_grid[5]));
+		_writer.writeAttribute("enabled", xmlWriter::number(_grid[6]));
+	}
+	_writer.writeEmptyElement("tracking");
+	_writer.writeAttribute("val", QString::number(_tracking));
+	_writer.writeEndElement();
+}
+
+void xmlWriter::write_ground_element(void) {
+	_writer.writeStartElement("ground");
+	for (unsigned int i = 0; i < _obstacles.size(); i++) {
+		const ObstacleSpec &s = _obstacles[i];
+		switch (s.type) {
+			case rs::BOX:		_writer.writeStartElement("box"); break;
+			case rs::CYLINDER:	_writer.writeStartElement("cylinder"); break;
+			case rs::SPHERE:	_writer.writeStartElement("sphere"); break;
+			default:			continue;
+		}
+		_writer.writeAttribute("mass", xmlWriter::number(s.mass));
+		_writer.writeEmptyElement("position");
+		_writer.writeAttribute("x", xmlWriter::number(s.p[0]));
+		_writer.writeAttribute("y", xmlWriter::number(s.p[1]));
+		_writer.writeAttribute("z", xmlWriter::number(s.p[2]));
+		_writer.writeEmptyElement("rotation");
+		_writer.writeAttribute("psi", xmlWriter::number(s.r[2]));
+		_writer.writeAttribute("theta", xmlWriter::number(s.r[1]));
+		_writer.writeAttribute("phi", xmlWriter::number(s.r[0]));
+		_writer.writeEmptyElement("size");
+		if (s.type == rs::BOX) {
+			_writer.writeAttribute("x", xmlWriter::number(s.l[0]));
+			_writer.writeAttribute("y", xmlWriter::number(s.l[1]));
+			_writer.writeAttribute("z", xmlWriter::number(s.l[2]));
+		}
+		else {
+			_writer.writeAttribute("radius", xmlWriter::number(s.l[0]));
+			_writer.writeAttribute("length", xmlWriter::number(s.l[1]));
+		}
+		_writer.writeEmptyElement("color");
+		_writer.writeAttribute("r", xmlWriter::number(s.c[0]));
+		_writer.writeAttribute("g", xmlWriter::number(s.c[1]));
+		_writer.writeAttribute("b", xmlWriter::number(s.c[2]));
+		_writer.writeAttribute("alpha", xmlWriter::number(s.c[3]));
+		_writer.writeEndElement();
+	}
+	_writer.writeEndElement();
+}
+
+void xmlWriter::write_sim_element(void) {
+	_writer.writeStartElement("sim");
+	for (int i = 0; i < _model->rowCount(); i++) {
+		QString tag = xmlWriter::robotTag(_model->getInt(i, FORM), _model->getInt(i, PRECONFIG));
+		if (tag.isEmpty()) continue;
+
+		double p[3], r[3];
+		_model->getPosition(i, p);
+		_model->getRotation(i, r);
+
+		_writer.writeStartElement(tag);
+		_writer.writeAttribute("id", QString::number(_model->getInt(i, ID)));
+		_writer.writeEmptyElement("position");
+		_writer.writeAttribute("x", xmlWriter::number(p[0]));
+		_writer.writeAttribute("y", xmlWriter::number(p[1]));
+		_writer.writeAttribute("z", xmlWriter::number(p[2]));
+		_writer.writeEmptyElement("rotation");
+		_writer.writeAttribute("psi", xmlWriter::number(r[2]));
+		_writer.writeAttribute("theta", xmlWriter::number(r[1]));
+		_writer.writeAttribute("phi", xmlWriter::number(r[0]));
+		if (_model->getInt(i, WHEEL)) {
+			_writer.writeEmptyElement("wheels");
+			_writer.writeAttribute("val", QString::number(_model->getInt(i, WHEEL)));
+			_writer.writeAttribute("radius", xmlWriter::number(_model->getDouble(i, RADIUS)));
+		}
+		_writer.writeEndElement();
+	}
+	_writer.writeEndElement();
+}
+
+/*!
+	Formats a double with as few digits as read back to the same value,
+	so scenes survive a round trip through XML unchanged.
+*/
+QString xmlWriter::number(double value) {
+	QString text = QString::number(value, 'g', 15);
+	if (text.toDouble() != value)
+		text = QString::number(value, 'g', 17);
+	return text;
+}
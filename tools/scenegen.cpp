@@ -0,0 +1,229 @@
+/*
+	Writes synthetic robosimrc scenes for scaling tests. The same options
+	and seed always give the same file.
+
+	RoboSimGen [--robots n] [--obstacles n] [--seed n] [--density robots/m^2]
+			   [--preconfigs fraction] [--forms form:weight,...] [--output file]
+
+	Forms are linkboti, linkbotl, linkbott and mobot. The default mix is
+	linkboti:6,linkbotl:3,linkbott:1. Mobots have to be asked for, since
+	RoboSim cannot draw them and batch mode rejects them in scene graphs.
+*/
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QStringList>
+
+#include "preconfig.h"
+#include "robotmodel.h"
+#include "spatialindex.h"
+#include "xmlreader.h"
+#include "xmlwriter.h"
+
+namespace {
+	/*
+		Small xorshift generator, so scenes do not depend on the platform's
+		rand().
+	*/
+	class sceneRandom {
+		public:
+			sceneRandom(quint32 seed) : _state((seed) ? seed : 0x9e3779b9) {}
+			quint32 next(void) {
+				_state ^= _state << 13;
+				_state ^= _state >> 17;
+				_state ^= _state << 5;
+				return _state;
+			}
+			double uniform(double min, double max) {
+				return min + (max - min)*(this->next()/4294967296.0);
+			}
+			int below(int n) {
+				return static_cast<int>(this->next() % static_cast<quint32>(n));
+			}
+
+		private:
+			quint32 _state;
+	};
+
+	struct formWeight {
+		int form;
+		int weight;
+	};
+
+	int form_from_name(const QString &name) {
+		if (name == "linkboti") return rs::LINKBOTI;
+		else if (name == "linkbotl") return rs::LINKBOTL;
+		else if (name == "linkbott") return rs::LINKBOTT;
+		else if (name == "mobot") return rs::MOBOT;
+		return -1;
+	}
+
+	int usage(void) {
+		std::cerr << "usage: RoboSimGen [--robots n] [--obstacles n] [--seed n] [--density robots/m^2]" << std::endl
+				  << "                  [--preconfigs fraction] [--forms form:weight,...] [--output file]" << std::endl;
+		return 1;
+	}
+}
+
+int main(int argc, char *argv[]) {
+	QCoreApplication app(argc, argv);
+
+	// parse options
+	int robots = 10, obstacles = 0;
+	quint32 seed = 1;
+	double density = 10, preconfigs = 0;
+	QString output;
+	std::vector<formWeight> forms;
+	QStringList args = app.arguments();
+	for (int i = 1; i < args.size(); i++) {
+		bool ok = true;
+		if (i + 1 >= args.size())
+			return usage();
+		else if (args[i] == "--robots")
+			robots = args[++i].toInt(&ok);
+		else if (args[i] == "--obstacles")
+			obstacles = args[++i].toInt(&ok);
+		else if (args[i] == "--seed")
+			seed = args[++i].toUInt(&ok);
+		else if (args[i] == "--density")
+			density = args[++i].toDouble(&ok);
+		else if (args[i] == "--preconfigs")
+			preconfigs = args[++i].toDouble(&ok);
+		else if (args[i] == "--output")
+			output = args[++i];
+		else if (args[i] == "--forms") {
+			QStringList list = args[++i].split(",", QString::SkipEmptyParts);
+			for (int j = 0; j < list.size() && ok; j++) {
+				formWeight fw;
+				fw.form = form_from_name(list[j].section(':', 0, 0));
+				fw.weight = list[j].section(':', 1, 1).toInt(&ok);
+				if (fw.form < 0 || fw.weight < 0) ok = false;
+				forms.push_back(fw);
+			}
+		}
+		else
+			ok = false;
+		if (!ok) return usage();
+	}
+	if (robots < 0 || obstacles < 0 || density <= 0 || preconfigs < 0 || preconfigs > 1)
+		return usage();
+
+	// default mix of forms
+	if (forms.empty()) {
+		formWeight fw;
+		fw.form = rs::LINKBOTI; fw.weight = 6; forms.push_back(fw);
+		fw.form = rs::LINKBOTL; fw.weight = 3; forms.push_back(fw);
+		fw.form = rs::LINKBOTT; fw.weight = 1; forms.push_back(fw);
+	}
+	int total = 0;
+	for (unsigned int i = 0; i < forms.size(); i++)
+		total += forms[i].weight;
+	if (total <= 0) return usage();
+
+	// preconfigs with templates
+	std::vector<int> types;
+	for (int i = 0; i < rsLinkbot::NUM_PRECONFIG; i++) {
+		if (rsModel::preconfigTemplate(i)) types.push_back(i);
+	}
+
+	// square area holding the robots at the requested density
+	double half = 0.5*sqrt((robots + obstacles)/density);
+	half = qMax(half, 0.5);
+	sceneRandom rng(seed);
+	robotModel model;
+	model.removeRows(0, model.rowCount());
+	spatialIndex index;
+	int row = 0;
+
+	// obstacles
+	std::vector<rsModel::ObstacleSpec> ground(obstacles);
+	for (int i = 0; i < obstacles; i++) {
+		rsModel::ObstacleSpec &o = ground[i];
+		switch (rng.below(3)) {
+			case 0: o.type = rs::BOX; break;
+			case 1: o.type = rs::CYLINDER; break;
+			default: o.type = rs::SPHERE; break;
+		}
+		o.l[0] = rng.uniform(0.05, 0.3);
+		o.l[1] = (o.type == rs::BOX) ? rng.uniform(0.05, 0.3) : rng.uniform(0.05, 0.2);
+		o.l[2] = (o.type == rs::BOX) ? rng.uniform(0.05, 0.3) : 0;
+		o.mass = (rng.below(2)) ? rng.uniform(0.1, 2) : 0;
+		for (int j = 0; j < 3; j++)
+			o.c[j] = rng.uniform(0, 1);
+		double hx = (o.type == rs::BOX) ? 0.5*o.l[0] : o.l[0];
+		double hy = (o.type == rs::BOX) ? 0.5*o.l[1] : o.l[0];
+		double x = rng.uniform(-half, half), y = rng.uniform(-half, half);
+		if (!index.overlapping(x, y, hx, hy, 0).empty())
+			index.nearestFree(x, y, hx, hy, 0, &x, &y);
+		o.p[0] = x;
+		o.p[1] = y;
+		o.p[2] = (o.type == rs::BOX) ? 0.5*o.l[2] : o.l[0];
+		index.insertRows(row, 1);
+		index.update(row++, x, y, hx, hy, 0);
+	}
+
+	// robots
+	std::vector<rsModel::RobotSpec> specs(robots);
+	for (int i = 0; i < robots; i++) {
+		rsModel::RobotSpec &spec = specs[i];
+		if (!types.empty() && rng.uniform(0, 1) < preconfigs) {
+			spec.form = rs::LINKBOTI;
+			spec.preconfig = types[rng.below(types.size())];
+		}
+		else {
+			int pick = rng.below(total);
+			unsigned int j = 0;
+			while (pick >= forms[j].weight) pick -= forms[j++].weight;
+			spec.form = forms[j].form;
+		}
+		if (spec.form == rs::LINKBOTI || spec.preconfig)
+			spec.wheel = 1 + rng.below(3);
+		spec.r[2] = 90*rng.below(4);
+
+		double hx, hy, angle = spec.r[2]*0.017453292519943295;
+		model.getFootprint(spec, &hx, &hy);
+		double x = rng.uniform(-half, half), y = rng.uniform(-half, half);
+		if (!index.overlapping(x, y, hx, hy, angle).empty())
+			index.nearestFree(x, y, hx, hy, angle, &x, &y);
+		spec.p[0] = x;
+		spec.p[1] = y;
+		index.insertRows(row, 1);
+		index.update(row++, x, y, hx, hy, angle);
+	}
+	model.addRobots(specs);
+
+	// grid covering the area, in inch tics and foot lines
+	double edge = ceil(half*39.37/12)*12/39.37;
+	std::vector<double> grid;
+	grid.push_back(1/39.37);
+	grid.push_back(12/39.37);
+	grid.push_back(-edge);
+	grid.push_back(edge);
+	grid.push_back(-edge);
+	grid.push_back(edge);
+	grid.push_back(1);
+
+	// write scene
+	xmlWriter writer(&model);
+	writer.setGrid(grid);
+	writer.setObstacles(ground);
+	QFile file;
+	if (output.isEmpty())
+		file.open(stdout, QIODevice::WriteOnly);
+	else {
+		file.setFileName(output);
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+			std::cerr << "Error: Cannot write " << qPrintable(output) << std::endl;
+			return 1;
+		}
+	}
+	if (!writer.write(&file)) {
+		std::cerr << "Error: Cannot write scene" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}